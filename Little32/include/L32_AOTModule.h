@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef L32_AOTModule_h_
+#define L32_AOTModule_h_
+
+// Shared between Little32AOTCore and the modules Little32Recompiler writes, so it only uses plain types
+
+#include "L32_Types.h"
+
+#ifdef _WIN32
+#define L32_AOT_EXPORT extern "C" __declspec(dllexport)
+#else
+#define L32_AOT_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// The name of the function every module exports, which returns its AOTModule
+#define L32_AOT_MODULE_SYMBOL "Little32Module"
+
+namespace Little32
+{
+	/// <summary> Bumped whenever the layout of anything in this file changes </summary>
+	constexpr word aot_module_version = 2;
+
+	/// <summary> The state of the core, as seen by recompiled code </summary>
+	struct AOTContext
+	{
+		/// <summary> R0 - R12, SP, LR and PC. PC is only kept up to date between blocks </summary>
+		word* registers = nullptr;
+		/// <summary> Packed as NZCV. Only kept up to date between blocks, and around calls to interpret </summary>
+		word flags = 0;
+
+		void* core = nullptr;
+
+		word (*read)(AOTContext& context, word address) = nullptr;
+		word (*read_byte)(AOTContext& context, word address) = nullptr;
+		void (*write)(AOTContext& context, word address, word value) = nullptr;
+		void (*write_byte)(AOTContext& context, word address, word value) = nullptr;
+
+		/// <summary> Runs the instruction at PC with the interpreter, for anything the recompiler doesn't translate </summary>
+		void (*interpret)(AOTContext& context) = nullptr;
+	};
+
+	/// <summary> Runs a recompiled basic block, and returns the number of instructions it ran </summary>
+	using AOTFunction = word (*)(AOTContext& context);
+
+	struct AOTBlock
+	{
+		word address;
+		word length; // In instructions
+		AOTFunction function;
+	};
+
+	struct AOTModule
+	{
+		word version;
+		/// <summary> The memory the module was recompiled from </summary>
+		word rom_start;
+		word rom_size;
+		/// <summary> Checksum of the memory the module was recompiled from, as calculated by AOTChecksum </summary>
+		word checksum;
+
+		word block_count;
+		/// <summary> Sorted by address </summary>
+		const AOTBlock* blocks;
+	};
+
+	using AOTModuleFunction = const AOTModule* (*)();
+
+	/// <summary> FNV-1a over a run of words </summary>
+	/// <param name="read">Returns the word at an index</param>
+	/// <param name="count">The number of words</param>
+	template<typename Read>
+	constexpr word AOTChecksum(Read read, word count)
+	{
+		word hash = 2166136261u;
+
+		for (word i = 0; i < count; i++)
+		{
+			const word w = read(i);
+
+			for (word b = 0; b < sizeof(word); b++)
+			{
+				hash ^= (w >> (b * 8)) & 0xFF;
+				hash *= 16777619u;
+			}
+		}
+
+		return hash;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -34,6 +34,8 @@ namespace Little32
 		std::shared_ptr<byte[]> memory;
 
 		word interrupt_address = 0;
+		/// <summary> The source frame interrupts are posted from </summary>
+		word interrupt_source = 0;
 
 		Computer& computer;
 		SDL::Renderer& r;
@@ -50,6 +52,8 @@ namespace Little32
 		CharDisplay(Computer& computer, SDL::Renderer& r, SDL::Texture& txt, const SDL::Point& charSize, word span, SDL::Point textSize, SDL::Point scale, word address, std::shared_ptr<byte[]>& memory);
 		CharDisplay(Computer& computer, SDL::Renderer& r, SDL::Texture& txt, const SDL::Point& charSize, word span, SDL::Point textSize, SDL::Point scale, word address);
 
+		~CharDisplay();
+
 		void Write(word address, word value);
 		void WriteByte(word address, byte value);
 
@@ -29,6 +29,9 @@ namespace Little32
 		word _ReadColourWordUnsafe(word address);
 		byte _ReadColourByteUnsafe(word address);
 
+		/// <summary> Returns where a block of words is kept if it's all text or all colour memory, otherwise null. Marks that memory dirty if it's for writing </summary>
+		byte* _FindBlockUnsafe(word address, word count, bool write);
+
 	public:
 		/// <summary> The start address of this RAM </summary>
 		word address_start = 0;
@@ -45,6 +48,9 @@ namespace Little32
 		/// <summary> The data used to fill colour memory when the device is reset </summary>
 		std::shared_ptr<byte[]> default_colour_memory = nullptr;
 		std::shared_ptr<byte[]> colour_memory;
+		/// <summary> Whether text or colour memory has been written since the last reset, and so need restoring </summary>
+		bool text_dirty = false;
+		bool colour_dirty = false;
 
 		inline static SDL::Colour colours[16] = {};
 
@@ -53,6 +59,8 @@ namespace Little32
 		std::shared_ptr<Computer::Interval> refresh_interval = nullptr;
 
 		Computer& computer;
+		/// <summary> The source frame interrupts are posted from </summary>
+		const word interrupt_source = computer.interrupts.AddSource();
 		SDL::Renderer r;
 		SDL::Texture txt;
 		/// <summary> The pixel size of a character from the source texture </summary>
@@ -83,6 +91,12 @@ namespace Little32
 		word Read(word address);
 		byte ReadByte(word address);
 
+		void ReadBlock(word address, word* values, word count);
+		void WriteBlock(word address, const word* values, word count);
+		void WriteBlockForced(word address, const word* values, word count);
+		void Fill(word address, word value, word count);
+		void FillForced(word address, word value, word count);
+
 		inline word GetAddress() const { return address_start; }
 		inline word GetRange() const { return address_size; }
 
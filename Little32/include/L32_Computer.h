@@ -4,11 +4,18 @@
 #define L32_Computer_h_
 
 #include "L32_Types.h"
-
+#include "L32_InterruptController.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
 #include <functional>
-#include <list>
-#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace Little32 
@@ -29,126 +36,219 @@ namespace Little32
 			size_t repeats = 0;
 		};
 
+		/// <summary> An interval waiting for the cycle it's due on. Intervals due on the same cycle run in the order they were scheduled </summary>
+		struct ScheduledInterval
+		{
+			size_t cycle;
+			size_t order;
+			std::shared_ptr<Interval> interval;
+
+			/// <summary> Orders the schedule as a min-heap, with the next interval due at the front </summary>
+			static inline bool Later(const ScheduledInterval& a, const ScheduledInterval& b)
+			{
+				return a.cycle != b.cycle ? a.cycle > b.cycle : a.order > b.order;
+			}
+		};
+
+		/// <summary> A device waiting for the cycle it next needs clocking on </summary>
+		struct ScheduledDevice
+		{
+			size_t cycle;
+			size_t order;
+			IDevice* device;
+
+			static inline bool Later(const ScheduledDevice& a, const ScheduledDevice& b)
+			{
+				return a.cycle != b.cycle ? a.cycle > b.cycle : a.order > b.order;
+			}
+		};
+
+		/// <summary> Awaited by a device's coroutine to sleep for a number of cycles, e.g. co_await computer.Cycles(100) </summary>
+		struct CycleAwaiter
+		{
+			size_t cycles;
+
+			inline bool await_ready() const noexcept { return cycles == 0; }
+
+			/// <summary> The coroutine's promise decides how it's woken up again, e.g. CoroutineDevice has the computer clock it </summary>
+			template<typename Promise>
+			inline void await_suspend(std::coroutine_handle<Promise> handle) const { handle.promise().SleepFor(cycles); }
+
+			inline void await_resume() const noexcept {}
+		};
+
+		/// <summary> Memory accesses that skip searching through every mapping, for when the layout is known ahead of time </summary>
+		struct Bus
+		{
+			word (*read)(Computer& computer, word addr);
+			byte (*read_byte)(Computer& computer, word addr);
+			void (*write)(Computer& computer, word addr, word value);
+			void (*write_byte)(Computer& computer, word addr, byte value);
+		};
+
+		// Memory is looked up a page at a time, so that accesses don't search through every mapping
+		static constexpr word page_bits = 12;
+		static constexpr word page_size = 1 << page_bits;
+		// Pages are allocated in groups, only where something is mapped
+		static constexpr word page_group_bits = 10;
+		static constexpr word page_group_size = 1 << page_group_bits;
+		static constexpr word page_group_count = 1 << (32 - page_bits - page_group_bits);
+
+		/// <summary> A device mapped to part of a page, with its place in memory cached </summary>
+		struct PageMapping
+		{
+			IMemoryMapped* device;
+			word start;
+			word range;
+		};
+
+		struct Page
+		{
+			/// <summary> The page's memory when all of it is plain memory from one RAM or ROM, otherwise null </summary>
+			word* read_memory = nullptr;
+			/// <summary> As read_memory, but only for RAM, once the RAM has seen the page written to since it was reset </summary>
+			word* write_memory = nullptr;
+			/// <summary> What write_memory is set to after the first write, and the RAM's record of whether that happened </summary>
+			word* ram_memory = nullptr;
+			const byte* ram_dirty = nullptr;
+			/// <summary> Whether everything mapped to the page is ROM, so writes that aren't forced can't change it </summary>
+			bool read_only = false;
+			/// <summary> Every device mapped to part of this page, in the order they're searched </summary>
+			std::vector<PageMapping> mappings;
+		};
+
+		using PageGroup = std::array<Page, page_group_size>;
+
 		ICore* core = nullptr;
+		/// <summary> Used for reads and writes instead of the mappings when set, e.g. by StaticComputer. Cleared when devices are added, as they change the layout it was bound to </summary>
+		const Bus* bus = nullptr;
 		std::vector<IDevice*> devices = {};
 		std::vector<IMemoryMapped*> mappings = {};
 		std::vector<IMappedDevice*> mapped_devices = {};
-		std::map<size_t, std::list<std::shared_ptr<Interval>>> intervals = {};
-		std::list<std::shared_ptr<Interval>> constant_intervals = {};
+		/// <summary> Intervals that run every clock </summary>
+		std::vector<std::shared_ptr<Interval>> constant_intervals = {};
+		/// <summary> Every other interval, as a min-heap of when they're next due. Only allocates when it outgrows its capacity </summary>
+		std::vector<ScheduledInterval> schedule = {};
+		/// <summary> Devices that want clocking, as a min-heap of when they're next due. Devices that never need it aren't in here at all </summary>
+		std::vector<ScheduledDevice> device_schedule = {};
+		/// <summary> Counts up as intervals and devices are scheduled, to keep the order of those due on the same cycle </summary>
+		size_t schedule_order = 0;
+		/// <summary> Null where nothing is mapped. Rebuilt whenever a mapping is added </summary>
+		std::array<std::unique_ptr<PageGroup>, page_group_count> page_groups = {};
+		/// <summary> Pages with write_memory set, which go back through their RAM after a reset </summary>
+		std::vector<Page*> writable_pages = {};
 		size_t cur_cycle = 0;
+		/// <summary> The earliest cycle any interval or device clock is due on, or 0 while any interval runs every clock </summary>
+		size_t next_deadline = SIZE_MAX;
+		/// <summary> Set by the core when it runs a HALT, so the computer knows to check whether it can skip ahead </summary>
+		bool halted = false;
+		/// <summary> Set when an interval is scheduled sooner than the next deadline, so the core stops its run early for the computer to catch up </summary>
+		bool yield = false;
+		/// <summary> The computer the calling thread is clocking, if any, so interrupts posted from inside its run know to stop it </summary>
+		static inline thread_local const Computer* clocking = nullptr;
+
+		inline void Schedule(size_t cycle, const std::shared_ptr<Interval>& interval)
+		{
+			schedule.push_back({ cycle, schedule_order++, interval });
+			std::push_heap(schedule.begin(), schedule.end(), ScheduledInterval::Later);
+
+			if (cycle >= next_deadline) return;
+
+			next_deadline = cycle;
+			yield = true;
+		}
+
+		inline void UpdateDeadline()
+		{
+			if (!constant_intervals.empty()) next_deadline = 0;
+			else next_deadline = std::min
+			(
+				schedule.empty() ? SIZE_MAX : schedule.front().cycle,
+				device_schedule.empty() ? SIZE_MAX : device_schedule.front().cycle
+			);
+		}
 
 		const std::shared_ptr<Interval> AddInterval(const size_t length, const IntervalFunction& interval, size_t repeats = 0)
 		{
+			const std::shared_ptr<Interval> i(new Interval{ length, interval, repeats });
+
 			// It runs every clock, so we dont want to move this around
 			if (length == 1)
 			{
-				constant_intervals.push_back(std::shared_ptr<Interval>(new Interval{ 1, interval, repeats }));
-				return constant_intervals.back();
-			}
-			
-			// Length == 0 is treated like once per overflow;
-			// i.e., once it returns to this cur_cycle
-			else if (intervals.empty() || intervals.count(cur_cycle + length) == 0)
-			{
-				auto& i = (intervals[cur_cycle + length] = { std::shared_ptr<Interval>(new Interval{ length, interval, repeats }) });
-				return i.front();
+				constant_intervals.push_back(i);
+				next_deadline = 0;
+				yield = true;
 			}
-			else
+
+			// Length == 0 is treated like once per overflow, which the cycle count never gets to
+			else if (length != 0)
 			{
-				auto& i = intervals[cur_cycle + length];
-				i.push_back(std::shared_ptr<Interval>(new Interval { length, interval, repeats }));
-				return i.back();
+				Schedule(Now() + length, i);
 			}
+
+			return i;
 		}
 
 		bool RemoveInterval(const std::shared_ptr<Interval> interval)
 		{
-			auto it = constant_intervals.begin();
-			auto it_end = constant_intervals.end();
+			const auto constant = std::find(constant_intervals.begin(), constant_intervals.end(), interval);
 
-			while (it != it_end)
+			if (constant != constant_intervals.end())
 			{
-				if ((it++)->get() != interval.get()) continue;
-
-				constant_intervals.erase(it);
+				constant_intervals.erase(constant);
+				UpdateDeadline();
 				return true;
 			}
 
-			for (auto& [num, group] : intervals)
-			{
-				it = group.begin();
-				it_end = group.end();
-
-				do
-				{
-					if (it->get() != interval.get()) continue;
-
-					intervals[num].erase(it);
-					// Don't leave any empty lists behind
-					if (intervals[num].empty()) intervals.erase(num);
-					return true;
-				} while ((++it) != it_end);
-			}
-
-			return false;
-		}
-
-		inline void CheckIntervals()
-		{
-			for (auto it = constant_intervals.begin(); it != constant_intervals.end();)
-			{
-				Interval* const i = it->get();
-				i->callback(*this);
-
-				if (i->repeats == 1)
-				{
-					it = constant_intervals.erase(it);
-					continue;
-				}
+			const auto scheduled = std::find_if(schedule.begin(), schedule.end(), [&](const ScheduledInterval& s) { return s.interval == interval; });
 
-				--(i->repeats);
-				++it;
-			}
+			if (scheduled == schedule.end()) return false;
 
-			if (intervals.count(cur_cycle) > 0)
-			{
-				auto& list = intervals[cur_cycle];
+			// Anything could have moved into its place, so the heap is rebuilt around the hole
+			*scheduled = std::move(schedule.back());
+			schedule.pop_back();
+			std::make_heap(schedule.begin(), schedule.end(), ScheduledInterval::Later);
 
-				std::list<std::shared_ptr<Interval>> old_intervals = {};
-				old_intervals.swap(list);
+			UpdateDeadline();
+			return true;
+		}
 
-				do
-				{
-					Interval* const i = old_intervals.front().get();
+		/// <summary> The current cycle, including however far the core has got through its current run </summary>
+		size_t Now() const;
 
-					i->callback(*this);
+		/// <summary> For a device's coroutine to sleep for a number of cycles </summary>
+		inline CycleAwaiter Cycles(size_t cycles) const { return { cycles }; }
 
-					if (i->repeats == 1)
-					{
-						old_intervals.pop_front();
-						continue;
-					}
+		/// <summary> The cycle the next interval or device clock is due on, so the core can run uninterrupted until then. The current cycle while any interval runs every clock </summary>
+		inline size_t NextDeadline() const { return std::max(next_deadline, cur_cycle); }
 
-					--(i->repeats);
+		inline void CheckIntervals()
+		{
+			if (cur_cycle >= next_deadline) RunIntervals();
+		}
 
-					if (intervals.count(cur_cycle + i->cycle_length) == 0)
-					{
-						intervals[cur_cycle + i->cycle_length] = {};
-					}
+		/// <summary> Runs every interval, and clocks every device, that's due on the current cycle </summary>
+		void RunIntervals();
 
-					auto& i2 = intervals[cur_cycle + i->cycle_length];
+		/// <summary> Asks a device when it next needs to be clocked, replacing when it was due before. For when a device changes what it's doing, e.g. a timer being started </summary>
+		void ScheduleClock(IDevice& device);
 
-					i2.push_back(old_intervals.front());
-					old_intervals.pop_front();
-				} while (!old_intervals.empty());
+		/// <summary> Stops clocking a device, for before it's deleted. Returns whether it was scheduled </summary>
+		bool Unschedule(IDevice& device);
 
-				if (list.empty()) intervals.erase(cur_cycle);
-			}
-		}
+		/// <summary> Where devices and host threads post interrupts, to be delivered between the core's runs </summary>
+		InterruptController interrupts{ *this };
 
 		word start_PC = 0;
 		word start_SP = 0;
 
+		std::mutex wait_mutex;
+		std::condition_variable wait_condition;
+		/// <summary> Whether the core was interrupted since WaitForInterrupt started waiting </summary>
+		bool interrupted = false;
+		/// <summary> Set while a thread is parked in WaitForInterrupt, so interrupts only take wait_mutex when there's a thread to wake </summary>
+		std::atomic<bool> parked = false;
+
 		Computer() : devices(), mappings(), mapped_devices() {}
 		~Computer()
 		{
@@ -169,13 +269,25 @@ namespace Little32
 			mappings.clear();
 		}
 
-		/// <summary> Clocks the computer a number of times </summary>
+		/// <summary> Clocks the computer a number of times, letting the core run uninterrupted between intervals and device clocks </summary>
 		/// <param name="clocks">Number of times to clock the computer</param>
 		void Clock(unsigned clocks);
 
 		/// <summary> Clocks the computer once </summary>
 		void Clock();
 
+		/// <summary> Skips the cycles a halted core would spend spinning, up to the next interval or device clock </summary>
+		/// <param name="clocks">The most cycles to skip, including the current one</param>
+		/// <returns>The number of cycles skipped</returns>
+		unsigned SkipHalt(unsigned clocks);
+
+		/// <summary> Parks the calling thread while the core is halted, e.g. by WFI, until it's interrupted or the timeout passes. Only another thread can wake it, so it's for hosts whose interrupts are posted from threads other than the one clocking the computer </summary>
+		/// <param name="timeout">The longest to wait, e.g. until the next frame</param>
+		void WaitForInterrupt(std::chrono::milliseconds timeout);
+
+		/// <summary> Wakes a thread parked in WaitForInterrupt. Safe to call from any thread, and only locks when a thread is parked </summary>
+		void NotifyInterrupt();
+
 		word Read(word addr);
 
 		byte ReadByte(word addr);
@@ -188,17 +300,55 @@ namespace Little32
 		void WriteForced(word addr, word value);
 		void WriteByteForced(word addr, byte value);
 
+		// Consecutive words, the same as accessing them one at a time, but copied straight to and from memory where possible
+
+		void ReadBlock(word addr, word* values, word count);
+		void WriteBlock(word addr, const word* values, word count);
+		void WriteBlockForced(word addr, const word* values, word count);
+		void Fill(word addr, word value, word count);
+		void FillForced(word addr, word value, word count);
+
 		/// <summary> Puts the core back to where it started executing without resetting the whole computer </summary>
 		void SoftReset();
 
 		/// <summary> Resets the computer as if it were power cycled </summary>
 		void HardReset();
 
+		/// <summary> Moves ROM into the image cache once it's been programmed, so computers running the same program share it </summary>
+		void ShareImages();
+
 		void AddDevice(IDevice& dev);
 
 		void AddMapping(IMemoryMapped& map);
 
 		void AddMappedDevice(IMappedDevice& dev);
+
+		/// <summary> Returns the page containing an address, or null if nothing is mapped near it </summary>
+		inline const Page* FindPage(word addr) const
+		{
+			const PageGroup* group = page_groups[addr >> (page_bits + page_group_bits)].get();
+
+			return group == nullptr ? nullptr : &(*group)[(addr >> page_bits) & (page_group_size - 1)];
+		}
+
+		inline Page* FindPage(word addr)
+		{
+			PageGroup* group = page_groups[addr >> (page_bits + page_group_bits)].get();
+
+			return group == nullptr ? nullptr : &(*group)[(addr >> page_bits) & (page_group_size - 1)];
+		}
+
+		/// <summary> Lets a page be written to directly, once its RAM has tracked that it was written </summary>
+		inline void EnableWrites(Page& page)
+		{
+			if (page.write_memory != nullptr || page.ram_dirty == nullptr || *page.ram_dirty == 0) return;
+
+			page.write_memory = page.ram_memory;
+			writable_pages.push_back(&page);
+		}
+
+		/// <summary> Works out which devices every page of memory is mapped to </summary>
+		void BuildPageTable();
 	};
 }
 
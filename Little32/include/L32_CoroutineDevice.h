@@ -0,0 +1,158 @@
+#pragma once
+
+#ifndef L32_CoroutineDevice_h_
+#define L32_CoroutineDevice_h_
+
+#include "L32_IMappedDevice.h"
+
+#include <coroutine>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Little32
+{
+	struct Computer;
+
+	/// <summary>
+	/// A mapped device whose behaviour is written as a coroutine, instead of a state machine that's stepped every clock.
+	/// The coroutine sleeps on co_await computer.Cycles(n) or co_await BusWrite(address), and the computer only clocks the device once it's due to wake,
+	/// so nothing runs in between. Its memory is a bank of word registers, which the coroutine reads and writes directly.
+	/// </summary>
+	class CoroutineDevice : public IMappedDevice
+	{
+	public:
+		/// <summary> Returned by Main. Owns the coroutine, which waits to be started until the device is first clocked </summary>
+		class Task
+		{
+		public:
+			struct promise_type
+			{
+				CoroutineDevice* device = nullptr;
+
+				inline Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+				inline std::suspend_always initial_suspend() noexcept { return {}; }
+				// Stays suspended once it's finished, so the device can tell
+				inline std::suspend_always final_suspend() noexcept { return {}; }
+				inline void return_void() noexcept {}
+				// Thrown on to whatever resumed the coroutine, e.g. the computer clocking the device
+				inline void unhandled_exception() { throw; }
+
+				inline void SleepFor(size_t cycles) { device->SleepFor(cycles); }
+			};
+
+			Task() = default;
+			inline Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+			inline ~Task() { if (handle) handle.destroy(); }
+
+			inline Task& operator=(Task&& other) noexcept
+			{
+				if (this == &other) return *this;
+
+				if (handle) handle.destroy();
+				handle = std::exchange(other.handle, nullptr);
+				return *this;
+			}
+
+			Task(const Task&) = delete;
+			Task& operator=(const Task&) = delete;
+
+			inline explicit operator bool() const { return (bool)handle; }
+			inline bool Done() const { return handle.done(); }
+			inline void Resume() const { handle.resume(); }
+			inline promise_type& Promise() const { return handle.promise(); }
+
+		private:
+			std::coroutine_handle<promise_type> handle = nullptr;
+
+			inline explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+		};
+
+		/// <summary> Awaited to sleep until the guest writes to a register. Gives the value written </summary>
+		struct WriteAwaiter
+		{
+			CoroutineDevice& device;
+			word address;
+
+			inline bool await_ready() const noexcept { return false; }
+			inline void await_suspend(std::coroutine_handle<>) const noexcept { device.WaitForWrite(address); }
+			inline word await_resume() const noexcept { return device.written_value; }
+		};
+
+		/// <summary> As WriteAwaiter, but also wakes once a number of cycles pass. Gives nothing if nothing was written in time </summary>
+		struct TimedWriteAwaiter
+		{
+			CoroutineDevice& device;
+			word address;
+			size_t cycles;
+
+			inline bool await_ready() const noexcept { return false; }
+
+			inline void await_suspend(std::coroutine_handle<>) const
+			{
+				device.WaitForWrite(address);
+				device.SleepFor(cycles);
+			}
+
+			inline std::optional<word> await_resume() const noexcept
+			{
+				if (device.timed_out) return std::nullopt;
+				return device.written_value;
+			}
+		};
+
+		/// <summary> The start address of this device </summary>
+		word address_start = 0;
+		/// <summary> What the guest sees of the device, a word each </summary>
+		std::vector<word> registers;
+
+		Computer& computer;
+
+		/// <param name="register_count">The number of word registers mapped from the start address</param>
+		CoroutineDevice(Computer& computer, word address, word register_count);
+
+		/// <summary> The device's behaviour. Started on the first clock after the device is added, and again after each reset </summary>
+		virtual Task Main() = 0;
+
+		/// <summary> For the coroutine to sleep until the guest writes to a register </summary>
+		/// <param name="address">The register's address, relative to the start of the device</param>
+		inline WriteAwaiter BusWrite(word address) { return { *this, address }; }
+
+		/// <summary> For the coroutine to sleep until the guest writes to a register, or the number of cycles pass </summary>
+		inline TimedWriteAwaiter BusWrite(word address, size_t cycles) { return { *this, address, cycles }; }
+
+		void Clock();
+		size_t CyclesUntilClock();
+		void Reset();
+
+		void Write(word address, word value);
+		void WriteByte(word address, byte value);
+
+		void WriteForced(word address, word value);
+		void WriteByteForced(word address, byte value);
+
+		word Read(word address);
+		byte ReadByte(word address);
+
+		inline word GetAddress() const { return address_start; }
+		inline word GetRange() const { return (word)registers.size() * sizeof(word); }
+
+	private:
+		Task task;
+
+		bool sleeping = false;
+		size_t wake_cycle = 0;
+
+		bool waiting_for_write = false;
+		word awaited_address = 0;
+		word written_value = 0;
+		/// <summary> Whether the last timed write wait ran out, rather than seeing a write </summary>
+		bool timed_out = false;
+
+		void SleepFor(size_t cycles);
+		void WaitForWrite(word address);
+		void Resume();
+	};
+}
+
+#endif
\ No newline at end of file
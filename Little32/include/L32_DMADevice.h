@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef L32_DMADevice_h_
+#define L32_DMADevice_h_
+
+#include "L32_IDeviceFactory.h"
+#include "L32_IMappedDevice.h"
+
+#include <array>
+
+namespace Little32
+{
+	struct Computer;
+
+	/// <summary>
+	/// Copies or fills memory for the guest in one go, then interrupts. Contiguous transfers go through the computer's block accesses,
+	/// so RAM, ROM and displays are copied straight between their memory rather than a word at a time.
+	/// </summary>
+	struct DMADevice : public IMappedDevice
+	{
+		// Word offsets of the controller's registers
+
+		/// <summary> The address copied from, or the value to fill with </summary>
+		static constexpr word SOURCE = 0;
+		static constexpr word DESTINATION = 1;
+		/// <summary> The number of words to transfer </summary>
+		static constexpr word LENGTH = 2;
+		/// <summary> The number of bytes between each word, for both addresses. 4 after a reset </summary>
+		static constexpr word STRIDE = 3;
+		static constexpr word MODE = 4;
+		/// <summary> The interrupt posted once a transfer finishes, or 0 for none </summary>
+		static constexpr word INTERRUPT = 5;
+		/// <summary> Writing anything but 0 starts a transfer. Reads as the number of transfers finished since the last reset </summary>
+		static constexpr word START = 6;
+
+		static constexpr word register_count = 7;
+
+		/// <summary> Fills the destination with the source register, rather than copying from it </summary>
+		static constexpr word MODE_FILL = 0b001;
+		/// <summary> Reads every word from the same source address, e.g. a device's data register </summary>
+		static constexpr word MODE_HOLD_SOURCE = 0b010;
+		/// <summary> Writes every word to the same destination address </summary>
+		static constexpr word MODE_HOLD_DESTINATION = 0b100;
+
+		/// <summary> The most words copied through the buffer at once </summary>
+		static constexpr word chunk_words = 1024;
+
+		/// <summary> The start address of this controller </summary>
+		word address_start = 0;
+
+		word source = 0;
+		word destination = 0;
+		word length = 0;
+		word stride = sizeof(word);
+		word mode = 0;
+		word interrupt = 0;
+		word transfers = 0;
+
+		/// <summary> The source interrupts are posted from </summary>
+		word interrupt_source = 0;
+
+		Computer& computer;
+
+		DMADevice(Computer& computer, word address);
+		~DMADevice();
+
+		/// <summary> Does the transfer the registers describe, and posts the interrupt </summary>
+		void Transfer();
+
+		void Reset();
+
+		void Write(word address, word value);
+		void WriteByte(word address, byte value);
+
+		void WriteForced(word address, word value);
+		void WriteByteForced(word address, byte value);
+
+		word Read(word address);
+		byte ReadByte(word address);
+
+		inline word GetAddress() const { return address_start; }
+		inline word GetRange() const { return register_count * sizeof(word); }
+
+		constexpr const Device_ID GetID() const { return DMA_DEVICE; }
+
+	private:
+		/// <summary> Where copies are read into before they're written, so the source and destination can overlap </summary>
+		std::array<word, chunk_words> buffer = {};
+
+		void Copy();
+	};
+
+	struct DMADeviceFactory : IDeviceFactory
+	{
+		void CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path path) const;
+		void VerifySettings(const IDeviceSettings& settings, std::filesystem::path path) const;
+	};
+}
+
+#endif
\ No newline at end of file
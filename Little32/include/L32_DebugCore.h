@@ -32,6 +32,7 @@ namespace Little32
 
 		void SetPC(word value);
 		void SetSP(word value);
+		word GetSP() const;
 	};
 }
 
@@ -21,6 +21,28 @@ namespace Little32
 
 		virtual void SetPC(word value) = 0;
 		virtual void SetSP(word value) = 0;
+		virtual word GetSP() const = 0;
+
+		/// <summary> Tells the core that memory has been written to, so anything it has cached about that memory is stale </summary>
+		/// <param name="address">The first address that was written to</param>
+		/// <param name="range">The number of bytes written</param>
+		virtual void InvalidateCache(word address, word range) {}
+
+		/// <summary> Discards everything the core has cached about memory </summary>
+		virtual void FlushCache() {}
+
+		/// <summary>
+		/// Runs up to budget cycles in one go, so the computer isn't stepping the core a cycle at a time.
+		/// Returns early once the core halts, or when the computer asks it to yield, e.g. because an interval was scheduled sooner.
+		/// </summary>
+		/// <returns>The number of cycles run, at least 1</returns>
+		virtual word Run(word budget) { Clock(); return 1; }
+
+		/// <summary> How many cycles the run in progress has got through, so a device accessed part way through one can tell the exact cycle. 0 between runs </summary>
+		virtual word CyclesRun() const { return 0; }
+
+		/// <summary> Whether the core is spinning on an instruction that branches to itself, so clocking it changes nothing until it's interrupted </summary>
+		virtual bool IsHalted() { return false; }
 
 		inline constexpr ~ICore() {}
 	};
@@ -3,15 +3,27 @@
 #ifndef L32_IDevice_h_
 #define L32_IDevice_h_
 
+#include <cstddef>
+#include <cstdint>
+
 namespace Little32
 {
 	struct Computer;
 
 	struct IDevice
 	{
+		/// <summary> Returned by CyclesUntilClock when the device doesn't need clocking, e.g. because it only responds to memory accesses </summary>
+		static constexpr size_t never = SIZE_MAX;
+
 		/// <summary> Clocks the device</summary>
 		virtual void Clock() {}
 
+		/// <summary>
+		/// The number of cycles until the device next needs to be clocked, or never. Only devices that override Clock need this.
+		/// Asked when the device is added, after each Clock and reset, and when the device calls Computer::ScheduleClock
+		/// </summary>
+		virtual size_t CyclesUntilClock() { return never; }
+
 		/// <summary> Reset the state of the device</summary>
 		virtual void Reset() {};
 
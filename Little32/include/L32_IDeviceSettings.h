@@ -57,6 +57,12 @@ namespace Little32
 			return settings.at(setting_name);
 		}
 
+		/// <summary> The priority of the device's interrupt source, from the interrupt_priority setting. 0 without one </summary>
+		word GetInterruptPriority() const;
+
+		/// <summary> Throws if the interrupt_priority setting isn't an unsigned word </summary>
+		void VerifyInterruptPriority() const;
+
 		bool operator==(const IDeviceSettings& other) const;
 
 		bool operator!=(const IDeviceSettings& other) const;
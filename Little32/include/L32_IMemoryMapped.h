@@ -40,6 +40,51 @@ namespace Little32
 		/// <param name="address">The address relative to <c>address_start</c></param>
 		virtual byte ReadByte(word address) { return 0; }
 
+		/// <summary>Reads consecutive words from this device, the same as reading them one at a time</summary>
+		/// <param name="address">The address of the first word, relative to <c>address_start</c></param>
+		/// <param name="values">Where the words are read to</param>
+		/// <param name="count">The number of words to read</param>
+		virtual void ReadBlock(word address, word* values, word count)
+		{
+			for (word i = 0; i < count; i++) values[i] = Read(address + i * sizeof(word));
+		}
+
+		/// <summary>Attempts to write consecutive words to this device, the same as writing them one at a time</summary>
+		/// <param name="address">The address of the first word, relative to <c>address_start</c></param>
+		/// <param name="values">The words to write</param>
+		/// <param name="count">The number of words to write</param>
+		virtual void WriteBlock(word address, const word* values, word count)
+		{
+			for (word i = 0; i < count; i++) Write(address + i * sizeof(word), values[i]);
+		}
+
+		/// <summary>Forces consecutive words to be written to this device. To be used to program the device.</summary>
+		/// <param name="address">The address of the first word, relative to <c>address_start</c></param>
+		/// <param name="values">The words to write</param>
+		/// <param name="count">The number of words to write</param>
+		virtual void WriteBlockForced(word address, const word* values, word count)
+		{
+			for (word i = 0; i < count; i++) WriteForced(address + i * sizeof(word), values[i]);
+		}
+
+		/// <summary>Attempts to write the same word to consecutive words of this device</summary>
+		/// <param name="address">The address of the first word, relative to <c>address_start</c></param>
+		/// <param name="value">The word to write</param>
+		/// <param name="count">The number of words to write</param>
+		virtual void Fill(word address, word value, word count)
+		{
+			for (word i = 0; i < count; i++) Write(address + i * sizeof(word), value);
+		}
+
+		/// <summary>Forces the same word to be written to consecutive words of this device. To be used to program the device.</summary>
+		/// <param name="address">The address of the first word, relative to <c>address_start</c></param>
+		/// <param name="value">The word to write</param>
+		/// <param name="count">The number of words to write</param>
+		virtual void FillForced(word address, word value, word count)
+		{
+			for (word i = 0; i < count; i++) WriteForced(address + i * sizeof(word), value);
+		}
+
 		/// <summary>Returns the start of the address space</summary>
 		virtual word GetAddress() const = 0;
 
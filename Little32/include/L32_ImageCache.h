@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef L32_ImageCache_h_
+#define L32_ImageCache_h_
+
+#include "L32_Types.h"
+
+#include <memory>
+
+namespace Little32
+{
+	/// <summary>
+	/// Memory images shared by every computer in the process, so that computers running the same program hold one copy of it between them.
+	/// Images are looked up by their contents, and each user gets a copy on write view of one, so what one computer writes is never seen by the others.
+	/// </summary>
+	class ImageCache
+	{
+	public:
+		/// <summary> Returns a copy on write view of an image with the given contents, creating the image if nothing is using one already </summary>
+		/// <param name="data">The contents of the image</param>
+		/// <param name="words">The size of the image in words</param>
+		/// <exception cref="std::runtime_error">Thrown when memory for the image can't be mapped</exception>
+		static std::shared_ptr<word[]> Map(const word* data, word words);
+
+		/// <summary> The number of distinct images still in use </summary>
+		static size_t Count();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#ifndef L32_InterruptController_h_
+#define L32_InterruptController_h_
+
+#include "L32_Types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Little32
+{
+	struct Computer;
+
+	/// <summary>
+	/// Collects interrupts from devices and host threads, and hands them to the core one at a time, only ever between instructions.
+	/// Each source has a priority and can be masked. An interrupt only preempts a handler that's running for one of a lower priority,
+	/// otherwise it waits until that handler returns with RFE.
+	/// </summary>
+	class InterruptController
+	{
+	public:
+		/// <summary> Sources are masked by bit, so there can only be as many as there are bits in a word </summary>
+		static constexpr word max_sources = sizeof(word) * 8;
+		/// <summary> The most interrupts that can be posted between deliveries before more are dropped. A power of 2 </summary>
+		static constexpr size_t queue_size = 256;
+
+		/// <summary> An interrupt that has been received, but not delivered </summary>
+		struct Pending
+		{
+			word source;
+			word address;
+		};
+
+		InterruptController(Computer& computer);
+
+		InterruptController(const InterruptController&) = delete;
+		InterruptController& operator=(const InterruptController&) = delete;
+
+		/// <summary> Adds a source for a device to post its interrupts from. Sources start unmasked </summary>
+		/// <param name="priority">Interrupts from sources with a higher priority are delivered first, and can preempt handlers of lower ones</param>
+		/// <returns>The source's number, the lowest that's free</returns>
+		/// <exception cref="std::runtime_error">Thrown when every source is in use</exception>
+		word AddSource(word priority = 0);
+
+		/// <summary> Frees a source for AddSource to hand out again, for when its device is deleted. Whatever it posted that hasn't been delivered is dropped </summary>
+		void RemoveSource(word source);
+
+		inline word GetPriority(word source) const { return priorities[source]; }
+		inline void SetPriority(word source, word priority) { priorities[source] = priority; }
+
+		/// <summary> Holds back interrupts from a source until it's unmasked. They aren't dropped </summary>
+		inline void Mask(word source) { mask |= (word)1 << source; }
+		inline void Unmask(word source) { mask &= ~((word)1 << source); }
+		inline bool IsMasked(word source) const { return (mask >> source) & 1; }
+
+		/// <summary> Queues an interrupt to be delivered at the next instruction boundary. Safe to call from any thread. Only locks to wake a thread parked in Computer::WaitForInterrupt </summary>
+		/// <param name="source">The source posting it, from AddSource</param>
+		/// <param name="address">Where the core jumps to handle it</param>
+		/// <returns>False if the queue was full, and the interrupt was dropped</returns>
+		bool Post(word source, word address);
+
+		/// <summary> Delivers whatever interrupts can be, highest priority first. Only called between instructions, from the thread clocking the computer </summary>
+		inline void Deliver()
+		{
+			if (pending.empty() && !HasPosted()) return;
+
+			DeliverPending();
+		}
+
+		/// <summary> Called by the core as it runs RFE, so interrupts held back by the handler it's leaving can be delivered </summary>
+		/// <param name="SP">The stack pointer before RFE pops anything</param>
+		void Return(word SP);
+
+		/// <summary> Whether any interrupts are waiting, including ones that are masked or held back by a running handler </summary>
+		inline bool HasPending() const { return !pending.empty() || HasPosted(); }
+
+		/// <summary> Whether anything has been posted since interrupts were last delivered </summary>
+		inline bool HasPosted() const
+		{
+			return queue[head & (queue_size - 1)].sequence.load(std::memory_order_acquire) == head + 1;
+		}
+
+		/// <summary> The number of interrupts dropped because the queue was full </summary>
+		inline size_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+		/// <summary> Forgets every interrupt that's waiting or being handled. Sources keep their priorities and masks </summary>
+		void Reset();
+
+	private:
+		/// <summary> A handler the core is running, and the stack pointer it will return with </summary>
+		struct InService
+		{
+			word priority;
+			word SP;
+		};
+
+		/// <summary> A slot of the queue, whose sequence says whose turn it is to use it, as in Vyukov's bounded queue </summary>
+		struct Slot
+		{
+			std::atomic<size_t> sequence;
+			word source;
+			word address;
+		};
+
+		Computer& computer;
+
+		std::array<Slot, queue_size> queue;
+		/// <summary> Where the next post goes. Shared by every posting thread </summary>
+		alignas(64) std::atomic<size_t> tail = 0;
+		/// <summary> Where the next interrupt is received from. Only used by the thread clocking the computer </summary>
+		alignas(64) size_t head = 0;
+
+		std::atomic<size_t> dropped = 0;
+
+		std::array<word, max_sources> priorities = {};
+		/// <summary> Bit n is set while source n is in use </summary>
+		word used = 0;
+		word mask = 0;
+
+		/// <summary> Interrupts that have been received, in the order they arrived </summary>
+		std::vector<Pending> pending;
+		/// <summary> Handlers that are running, innermost last </summary>
+		std::vector<InService> in_service;
+
+		/// <summary> Moves everything posted since last time into pending </summary>
+		void Receive();
+
+		void DeliverPending();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -22,6 +22,8 @@ namespace Little32
 		
 		word keydown_interrupt = 0;
 		word keyup_interrupt = 0;
+		/// <summary> The source key interrupts are posted from </summary>
+		word interrupt_source = 0;
 
 		word down_head = BUFFER_SIZE - 1;
 		word up_head = BUFFER_SIZE - 1;
@@ -35,6 +37,7 @@ namespace Little32
 		Computer& computer;
 
 		KeyboardDevice(Computer& computer, word address);
+		~KeyboardDevice();
 
 		void PushKeyDown(word key);
 		void PushKeyUp(word key);
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef L32_L32AOTCore_h_
+#define L32_L32AOTCore_h_
+
+#include "L32_AOTModule.h"
+#include "L32_L32Core.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace Little32
+{
+	/// <summary>
+	/// A Little32 core that runs ROM code recompiled ahead of time by Little32Recompiler, loaded from a shared library.
+	/// Code that wasn't recompiled, or a module that doesn't match what's in ROM, is run by the interpreter.
+	/// A run stops early when the computer asks it to, e.g. because a device was scheduled sooner, but only between blocks, as a block runs in one go.
+	/// </summary>
+	struct Little32AOTCore : public Little32Core
+	{
+
+		void* library = nullptr;
+		const AOTModule* module = nullptr;
+
+		/// <summary> Indexed by (address - rom_start) / 4, null where no block starts </summary>
+		std::vector<const AOTBlock*> block_table;
+
+		/// <summary> Whether the module matches what's currently in ROM </summary>
+		bool module_valid = false;
+		bool verify_pending = true;
+
+		AOTContext context;
+
+		/// <summary> The budget of the run in progress, and how much of it is left </summary>
+		word run_budget = 0;
+		word run_left = 0;
+
+
+		Little32AOTCore(Computer& computer);
+		~Little32AOTCore();
+
+		/// <summary> Loads a module written by Little32Recompiler, replacing any that was already loaded </summary>
+		/// <param name="path">The shared library the module was built into</param>
+		void Load(const std::filesystem::path& path);
+		void Unload();
+
+		void InvalidateCache(word address, word range);
+		void FlushCache();
+
+		/// <summary> Runs up to budget instructions </summary>
+		word Run(word budget);
+
+		/// <summary> Only counts whole blocks, as a block's cycles are taken from the budget once it's run </summary>
+		inline word CyclesRun() const { return run_cycles + (run_budget - run_left); }
+
+	private:
+		bool Verify();
+
+		static word ReadHelper(AOTContext& context, word address);
+		static word ReadByteHelper(AOTContext& context, word address);
+		static void WriteHelper(AOTContext& context, word address, word value);
+		static void WriteByteHelper(AOTContext& context, word address, word value);
+		static void InterpretHelper(AOTContext& context);
+	};
+}
+
+#endif
\ No newline at end of file
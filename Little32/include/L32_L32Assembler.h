@@ -155,6 +155,8 @@ namespace Little32
 			//          N001011p   ,   .   ,   .   ,
 			{"MVM",  {0b0001011000000000000000000000, PackType::RegList, true                 }},
 			{"SWP",  {0b0001011100000000000000000000, PackType::Reg2,    true                 }},
+			//          N0010000   ,   .   ,   .   ,
+			{"WFI",  {0b0001000000000000000000000000, PackType::None                          }},
 			//          N0001ppp   ,   .   ,   .   ,
 			{"ADDF", {0b0000100000000000000000000000, PackType::Reg3,    true,  false, false  }},
 			{"SUBF", {0b0000100100000000000000000000, PackType::Reg3,    true,  false, false  }},
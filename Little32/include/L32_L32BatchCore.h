@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef L32_L32BatchCore_h_
+#define L32_L32BatchCore_h_
+
+#include "L32_L32Core.h"
+
+#include <array>
+#include <vector>
+
+namespace Little32
+{
+	/// <summary>
+	/// Runs a batch of Little32 machines with the same code in lockstep, e.g. the same ROM with different inputs.
+	/// Their registers are laid out lane by lane, so that an instruction runs for every machine at once in vector registers.
+	/// Machines that reach a different PC wait for the others, following the lanes with the lowest PC so that loops reconverge.
+	/// Anything that touches memory, or code outside the shared range, is run by each machine's own core instead.
+	/// Only the cores are run: the devices and intervals of each machine's computer are not clocked.
+	/// </summary>
+	struct Little32BatchCore
+	{
+		// 8 lanes of 32 bits fill an AVX2 register
+		static constexpr size_t lanes = 8;
+
+		/// <summary> One value for each lane, aligned so that copying them is a single vector load and store </summary>
+		template<typename T>
+		struct alignas(32) Lanes : std::array<T, lanes> {};
+
+		using DecodedInstruction = Little32Core::DecodedInstruction;
+
+		/// <summary> Runs an instruction in every lane of exec, whose condition has passed. exec is all 1s for those lanes and 0 for the rest, so lanes are picked out with masks rather than branches </summary>
+		using Handler = void (Little32BatchCore::*)(const DecodedInstruction& d, Lanes<word> exec);
+
+		/// <summary> Each machine's core, which holds its state between runs. Every core needs its own computer </summary>
+		Lanes<Little32Core*> cores;
+
+		/// <summary> The code that's the same on every machine, and so can run in lockstep </summary>
+		word shared_start = 0;
+		word shared_size = 0;
+
+		alignas(32) Lanes<word> registers[16] {};
+
+		/// <summary> The status flags of each lane, packed as NZCV. Worked out straight away, as conditions are checked a lane at a time </summary>
+		alignas(32) Lanes<word> flags {};
+
+		/// <summary> The number of instructions run for every lane at once, and by a single core </summary>
+		size_t vector_steps = 0;
+		size_t scalar_steps = 0;
+
+		/// <param name="cores">The core of each machine</param>
+		Little32BatchCore(const Lanes<Little32Core*>& cores);
+
+		/// <summary> Sets the range of code that is the same on every machine, usually ROM </summary>
+		void SetSharedCode(word start, word size);
+
+		/// <summary> Discards decoded instructions, for when the shared code has been changed </summary>
+		void FlushCache();
+
+		/// <summary> Runs budget instructions on every machine </summary>
+		void Run(word budget);
+
+		// Instruction handlers, run for every lane at once
+
+		template<byte op, bool immediate, bool set_status, bool negative>
+		void ArithmeticHandler(const DecodedInstruction& d, Lanes<word> exec);
+		template<bool link>
+		void BranchHandler(const DecodedInstruction& d, Lanes<word> exec);
+		void ReturnHandler(const DecodedInstruction& d, Lanes<word> exec);
+		void NopHandler(const DecodedInstruction& d, Lanes<word> exec);
+
+	private:
+		/// <summary> A decoded instruction in the shared code, with no handler if it has to be run by each core </summary>
+		struct BatchInstruction
+		{
+			DecodedInstruction d;
+			Handler handler = nullptr;
+		};
+
+		/// <summary> Indexed by (address - shared_start) / 4 </summary>
+		std::vector<BatchInstruction> decode_cache;
+
+		const BatchInstruction* Fetch(word address);
+
+		void Load(size_t lane);
+		void Store(size_t lane);
+	};
+}
+
+#endif
\ No newline at end of file
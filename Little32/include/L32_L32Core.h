@@ -5,11 +5,24 @@
 
 #include "L32_ICore.h"
 
+#include <array>
+#include <vector>
+
 namespace Little32
 {
-	struct Little32Core : public ICore
+	/// <summary>
+	/// The Little32 interpreter, built against the type of computer whose memory it accesses.
+	/// Little32Core works with any Computer, while a StaticComputer builds one against itself so its reads and writes inline
+	/// </summary>
+	/// <typeparam name="Memory">Computer, or a type derived from it</typeparam>
+	template<typename Memory>
+	struct BasicLittle32Core : public ICore
 	{
-		Computer& computer;
+		/// <summary> The same core, built against another type of computer </summary>
+		template<typename Other>
+		using Rebind = BasicLittle32Core<Other>;
+
+		Memory& computer;
 
 		union {
 			struct
@@ -19,7 +32,26 @@ namespace Little32
 			word registers[16] { 0 };
 		};
 
-		bool N = false, Z = false, C = false, V = false; // Status flags
+		/// <summary> How the status flags are worked out from the last instruction that set them </summary>
+		enum class FlagOp : byte
+		{
+			PACKED,     // flag_result holds the packed NZCV flags
+			ARITHMETIC, // flag_result and flag_operand are the low and high words of a 64 bit result
+			CMN,        // As ARITHMETIC, but C is the 33rd bit of the result
+			ASL,        // flag_result was shifted from flag_operand by flag_shift
+			ASR,
+			LSL,
+			LSR,
+			LOGIC,      // N and Z from flag_result, C and V clear
+			MOVE        // Z from flag_result, V from the signs of flag_result and flag_operand (the old value)
+		};
+
+		// Status flags, only worked out when something reads them
+		FlagOp flag_op = FlagOp::PACKED;
+		bool flag_negative = false;
+		word flag_result = 0;
+		word flag_operand = 0;
+		word flag_shift = 0;
 
 		static constexpr const char N_flag = 0b1000;
 		static constexpr const char Z_flag = 0b0100;
@@ -49,6 +81,9 @@ namespace Little32
 		static constexpr const char NE = ZC;
 		static constexpr const char LO = CC;
 
+		/// <summary> Bit n of condition_masks[cond] is set if cond passes when the packed NZCV flags equal n </summary>
+		static const std::array<word, 16> condition_masks;
+
 		//                                         CCCCNxxxxxxi111122223333xxxxSSSS
 		static constexpr word cond_bits        = 0b11110000000000000000000000000000;
 		static constexpr word negative_bit     = 0b00001000000000000000000000000000;
@@ -79,20 +114,233 @@ namespace Little32
 		static constexpr word extended_op_bits = 0b00000000111100000000000000000000;
 		static constexpr word reglist_bits     = 0b00000000000000001111111111111111;
 
-		constexpr Little32Core(Computer& computer) : computer(computer) {}
+		struct DecodedInstruction;
+
+		/// <summary> Runs an instruction whose condition has passed </summary>
+		using Handler = void (BasicLittle32Core::*)(const DecodedInstruction& d);
+
+		/// <summary> An instruction with its fields already pulled out, so it doesn't have to be decoded every time it runs </summary>
+		struct DecodedInstruction
+		{
+			enum class Type : byte
+			{
+				NOP,
+				ARITHMETIC,
+				BRANCH,
+				EXTENDED,
+				FLOAT
+			};
+
+			/// <summary> The address this instruction was fetched from </summary>
+			word address = 0;
+			bool valid = false;
+
+			Type type = Type::NOP;
+			byte cond = AL;
+			/// <summary> The opcode within its type of instruction </summary>
+			byte op = 0;
+
+			byte reg1 = 0;
+			byte reg2 = 0;
+			byte reg3 = 0;
+			/// <summary> Barrel shift for flexible operands, already multiplied by 2 </summary>
+			byte shift = 0;
+
+			bool negative = false;
+			bool immediate = false;
+			bool set_status = false;
+			bool link = false;
+
+			/// <summary> Already rotated by shift </summary>
+			word imm8 = 0;
+			/// <summary> Already rotated by shift </summary>
+			word imm12 = 0;
+			/// <summary> Branch offset in bytes, already negated if needed </summary>
+			word offset = 0;
+			word reglist = 0;
+
+			/// <summary> The number of instructions covered, more than 1 if later instructions were fused into this one </summary>
+			byte length = 1;
+			/// <summary> The condition of the branch that ends a fused instruction </summary>
+			byte fused_cond = AL;
+
+			/// <summary> Specialised on the opcode and flags of this instruction </summary>
+			Handler handler = nullptr;
+		};
+
+		/// <summary> Common sequences of instructions that are run as one </summary>
+		enum class Fusion : byte
+		{
+			COMPARE_BRANCH, // CMP / CMN / TST, then B or BL
+			LOAD,           // MOV Rn, label, then RRW Rn, [Rn]
+			LOOP,           // INC / DEC Rn, then CMP Rn, then B or BL
+			COUNT
+		};
+
+		// Must be a power of 2
+		static constexpr word decode_cache_size = 4096;
+		// The most instructions that are fused together
+		static constexpr word max_fused_length = 3;
+
+		/// <summary> Decoded instructions, indexed by their address </summary>
+		std::vector<DecodedInstruction> decode_cache;
+
+		/// <summary> Set by WFI, so that an interrupt returns to the instruction after it instead of waiting again </summary>
+		bool waiting = false;
+
+		/// <summary> Whether Fetch fuses common sequences of instructions together </summary>
+		bool fuse_instructions = true;
+		/// <summary> Cycles still to be spent on instructions that were run early as part of a fused instruction </summary>
+		word fused_cycles = 0;
+		/// <summary> The number of times each kind of fused instruction has run </summary>
+		std::array<size_t, (size_t)Fusion::COUNT> fusion_counts {};
+		/// <summary> The cycles Run has got through so far. Kept here rather than on the stack so devices can ask for it </summary>
+		word run_cycles = 0;
+
+		static constexpr word max_register_banks = 8;
+
+		/// <summary> What a banked interrupt saves, kept in the core rather than pushed to the stack </summary>
+		struct RegisterBank
+		{
+			word registers[16];
+			word flags;
+		};
+
+		/// <summary> How many nested interrupts keep the flags and PC in a bank, instead of pushing them to the stack. 0 pushes them like always </summary>
+		word register_banks = 0;
+		/// <summary>
+		/// Bit n set for each register RFE puts back from the bank, so handlers can use them without saving them.
+		/// Handlers that leave results in registers for the code they interrupted need those bits clear. SP is never restored
+		/// </summary>
+		word banked_registers = 0b0101111111111111;
+		/// <summary> The number of banks in use, outermost handler first </summary>
+		word bank_depth = 0;
+		/// <summary> Handlers nested past the last bank, which pushed to the stack instead </summary>
+		word unbanked_depth = 0;
+		std::array<RegisterBank, max_register_banks> banks {};
+
+		BasicLittle32Core(Memory& computer);
 
 		void Clock();
 		void Interrupt(word address);
 		void Reset();
 
+		/// <summary> Runs instructions back to back until the budget runs out, the core halts, or the computer asks it to yield </summary>
+		word Run(word budget);
+
+		inline word CyclesRun() const { return run_cycles; }
+
+		static DecodedInstruction Decode(word instruction);
+
+		/// <summary> Fuses the instructions following a decoded instruction into it, if they form a common sequence </summary>
+		void Fuse(DecodedInstruction& d);
+
+		/// <summary> Returns the decoded instruction at an address, decoding it if it isn't cached </summary>
+		const DecodedInstruction& Fetch(word address);
+
+		void InvalidateCache(word address, word range);
+		void FlushCache();
+
+		/// <summary> Whether the next instruction is a HALT or WFI whose condition passes </summary>
+		bool IsHalted();
+
+		/// <summary> Works out the status flags, packed as NZCV </summary>
+		inline word GetFlags() const { return EvaluateFlags(flag_op, flag_result, flag_operand, flag_shift, flag_negative); }
+
+		/// <summary> Works out packed NZCV status flags from what they were deferred with </summary>
+		static constexpr word EvaluateFlags(FlagOp flag_op, word flag_result, word flag_operand, word flag_shift, bool flag_negative)
+		{
+			switch (flag_op)
+			{
+				case FlagOp::ARITHMETIC: return EvaluateFlags<FlagOp::ARITHMETIC>(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::CMN:        return EvaluateFlags<FlagOp::CMN       >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::ASL:        return EvaluateFlags<FlagOp::ASL       >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::ASR:        return EvaluateFlags<FlagOp::ASR       >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::LSL:        return EvaluateFlags<FlagOp::LSL       >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::LSR:        return EvaluateFlags<FlagOp::LSR       >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::LOGIC:      return EvaluateFlags<FlagOp::LOGIC     >(flag_result, flag_operand, flag_shift, flag_negative);
+				case FlagOp::MOVE:       return EvaluateFlags<FlagOp::MOVE      >(flag_result, flag_operand, flag_shift, flag_negative);
+				default:                 return flag_result; // PACKED
+			}
+		}
+
+		/// <summary> Works out packed NZCV status flags for a FlagOp known at compile time, without branching, so it can run on vectors </summary>
+		template<FlagOp flag_op>
+		static constexpr word EvaluateFlags(word flag_result, word flag_operand, word flag_shift, bool flag_negative)
+		{
+			static_assert(flag_op != FlagOp::PACKED, "Packed flags are already worked out");
+
+			const int32_t result = flag_result;
+			const int32_t operand = flag_operand;
+			// All 0s or 1s, so (x ^ neg) - neg is x * -1 when negative
+			const word neg = 0 - (word)flag_negative;
+
+			// MOV and INV compare an unsigned register with 0, so never set N
+			const bool N = flag_op != FlagOp::MOVE && result < 0;
+			const bool Z = result == 0;
+			// LOGIC clears C and V
+			const bool V = flag_op != FlagOp::LOGIC && (operand < 0) != (result < 0);
+			bool C = false;
+
+			if constexpr (flag_op == FlagOp::ARITHMETIC) C = operand != (result >> 31); // The 64 bit result didn't fit in 32 bits
+			if constexpr (flag_op == FlagOp::CMN)        C = (operand & 1) != 0;
+			if constexpr (flag_op == FlagOp::ASL)        C = flag_operand != (((flag_result ^ neg) - neg) >> flag_shift);
+			if constexpr (flag_op == FlagOp::ASR)        C = flag_operand != (((flag_result ^ neg) - neg) << flag_shift);
+			if constexpr (flag_op == FlagOp::LSL)        C = flag_operand != ((flag_result ^ neg) >> flag_shift);
+			if constexpr (flag_op == FlagOp::LSR)        C = flag_operand != ((flag_result ^ neg) << flag_shift);
+
+			return (N * N_flag) | (Z * Z_flag) | (C * C_flag) | (V * V_flag);
+		}
+
+		/// <summary> Sets the status flags from a packed NZCV value </summary>
+		void SetFlags(word flags);
+
+		/// <summary> Records what the status flags depend on, to be worked out by GetFlags </summary>
+		inline void DeferFlags(FlagOp op, word result, word operand = 0, word shift = 0, bool negative = false)
+		{
+			flag_op = op;
+			flag_result = result;
+			flag_operand = operand;
+			flag_shift = shift;
+			flag_negative = negative;
+		}
+
+		// Instruction handlers, specialised at compile time so they only do the work their instruction needs
+
+		template<byte op, bool immediate, bool set_status, bool negative>
+		void ArithmeticHandler(const DecodedInstruction& d);
+		template<bool link>
+		void BranchHandler(const DecodedInstruction& d);
+		void HaltHandler(const DecodedInstruction& d);
+		void ReturnHandler(const DecodedInstruction& d);
+		void ReturnFromInterruptHandler(const DecodedInstruction& d);
+		template<byte op, bool negative>
+		void ExtendedHandler(const DecodedInstruction& d);
+		template<byte op>
+		void FloatHandler(const DecodedInstruction& d);
+		void NopHandler(const DecodedInstruction& d);
+
+		template<byte op, bool immediate, bool negative, bool link>
+		void CompareBranchHandler(const DecodedInstruction& d);
+		template<bool immediate, bool negative>
+		void LoadHandler(const DecodedInstruction& d);
+		template<byte op, bool immediate, bool negative, bool link>
+		void LoopHandler(const DecodedInstruction& d);
+
 		const std::string Disassemble(word instruction) const;
 
 		void Push(word& ptr, word val);
 		word Pop(word& ptr);
 
-		constexpr void SetPC(word value) { PC = value; }
+		constexpr void SetPC(word value) { PC = value; waiting = false; }
 		constexpr void SetSP(word value) { SP = value; }
+		constexpr word GetSP() const { return SP; }
 	};
+
+	using Little32Core = BasicLittle32Core<Computer>;
+
+	// Built in L32_L32Core.cpp
+	extern template struct BasicLittle32Core<Computer>;
 }
 
 #endif
\ No newline at end of file
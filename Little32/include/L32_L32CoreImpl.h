@@ -0,0 +1,1004 @@
+#pragma once
+
+#ifndef L32_L32CoreImpl_h_
+#define L32_L32CoreImpl_h_
+
+#include "L32_L32Core.h"
+#include "L32_String.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// The definitions of BasicLittle32Core, for the computers it's built for.
+// Little32Core is built once in L32_L32Core.cpp, and a StaticComputer builds its own core against itself
+
+namespace Little32
+{
+	// The handler tables, built for each type of core, and the condition masks they share
+	namespace detail
+	{
+		// Indexed by (op << 3) | (immediate << 2) | (set_status << 1) | negative
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeArithmeticHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template ArithmeticHandler<(I >> 3), ((I >> 2) & 1) != 0, ((I >> 1) & 1) != 0, (I & 1) != 0>... };
+		}
+
+		// Indexed by (op << 1) | negative
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeExtendedHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template ExtendedHandler<(I >> 1), (I & 1) != 0>... };
+		}
+
+		// Indexed by op
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeFloatHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template FloatHandler<I>... };
+		}
+
+		template<typename Core>
+		constexpr auto arithmetic_handlers = MakeArithmeticHandlers<Core>(std::make_index_sequence<16 * 8>());
+		template<typename Core>
+		constexpr auto extended_handlers = MakeExtendedHandlers<Core>(std::make_index_sequence<16 * 2>());
+		// CMP, CMN and TST
+		constexpr byte compare_ops[] { 0b0110, 0b0111, 0b1011 };
+
+		// Indexed by (compare << 3) | (immediate << 2) | (negative << 1) | link, where compare indexes compare_ops
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeCompareBranchHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template CompareBranchHandler<compare_ops[I >> 3], ((I >> 2) & 1) != 0, ((I >> 1) & 1) != 0, (I & 1) != 0>... };
+		}
+
+		// Indexed by (immediate << 1) | negative
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeLoadHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template LoadHandler<((I >> 1) & 1) != 0, (I & 1) != 0>... };
+		}
+
+		// Indexed by (op << 3) | (immediate << 2) | (negative << 1) | link, where op is ADD or SUB
+		template<typename Core, size_t... I>
+		constexpr std::array<typename Core::Handler, sizeof...(I)> MakeLoopHandlers(std::index_sequence<I...>)
+		{
+			return { &Core::template LoopHandler<(I >> 3), ((I >> 2) & 1) != 0, ((I >> 1) & 1) != 0, (I & 1) != 0>... };
+		}
+
+		template<typename Core>
+		constexpr auto float_handlers = MakeFloatHandlers<Core>(std::make_index_sequence<8>());
+		template<typename Core>
+		constexpr auto compare_branch_handlers = MakeCompareBranchHandlers<Core>(std::make_index_sequence<3 * 8>());
+		template<typename Core>
+		constexpr auto load_handlers = MakeLoadHandlers<Core>(std::make_index_sequence<4>());
+		template<typename Core>
+		constexpr auto loop_handlers = MakeLoopHandlers<Core>(std::make_index_sequence<2 * 8>());
+
+		constexpr bool ConditionPasses(byte cond, word flags)
+		{
+			const bool N = (flags & Little32Core::N_flag) != 0;
+			const bool Z = (flags & Little32Core::Z_flag) != 0;
+			const bool C = (flags & Little32Core::C_flag) != 0;
+			const bool V = (flags & Little32Core::V_flag) != 0;
+
+			switch (cond)
+			{
+				case Little32Core::AL: return true;               // Always
+				case Little32Core::GT: return (N == V) && !Z;     // >
+				case Little32Core::GE: return N == V;             // >=
+				case Little32Core::HI: return C && !Z;            // > (unsigned)
+				case Little32Core::CS: return C;                  // >= (unsigned) / Carry set
+				case Little32Core::ZS: return Z;                  // == / Zero set
+				case Little32Core::NS: return N;                  // < 0 / Negative set
+				case Little32Core::VS: return V;                  // oVerflow set
+				case Little32Core::VC: return !V;                 // oVerflow not set
+				case Little32Core::NC: return !N;                 // >= 0 / Negative not set
+				case Little32Core::ZC: return !Z;                 // != / Zero not set
+				case Little32Core::CC: return !C;                 // < (unsigned) / Carry not set
+				case Little32Core::LS: return !C || Z;            // <= (unsigned)
+				case Little32Core::LT: return N != V;             // <
+				case Little32Core::LE: return (N != V) || Z;      // <=
+				default: return false;                            // Never
+			}
+		}
+
+		constexpr std::array<word, 16> MakeConditionMasks()
+		{
+			std::array<word, 16> masks {};
+
+			for (word cond = 0; cond < 16; cond++)
+			{
+				for (word flags = 0; flags < 16; flags++)
+				{
+					if (ConditionPasses((byte)cond, flags)) masks[cond] |= 1 << flags;
+				}
+			}
+
+			return masks;
+		}
+	}
+
+
+	template<typename Memory>
+	const std::array<word, 16> BasicLittle32Core<Memory>::condition_masks = detail::MakeConditionMasks();
+
+	template<typename Memory>
+	BasicLittle32Core<Memory>::BasicLittle32Core(Memory& computer) :
+		computer(computer),
+		decode_cache(decode_cache_size) {}
+
+	template<typename Memory>
+	typename BasicLittle32Core<Memory>::DecodedInstruction BasicLittle32Core<Memory>::Decode(word instruction)
+	{
+		using namespace std;
+
+		DecodedInstruction d;
+
+		d.cond       = (instruction & cond_bits) >> 28;
+		d.negative   = (instruction & negative_bit ) != 0;
+		d.immediate  = (instruction & immediate_bit) != 0;
+		d.set_status = (instruction & status_bit   ) != 0;
+		d.link       = (instruction & link_bit     ) != 0;
+		d.shift      = (instruction & shift_bits) * 2;
+		d.imm8       = rotl((instruction & imm8_bits) >> 4, d.shift);
+		d.imm12      = rotl((instruction & imm12_bits) >> 4, d.shift);
+		d.reg1       = (instruction & reg1_bits) >> 16;
+		d.reg2       = (instruction & reg2_bits) >> 12;
+		d.reg3       = (instruction & reg3_bits) >> 8;
+		d.offset     = (instruction & offset_bits) * sizeof(word) * (d.negative ? -1 : 1);
+		d.reglist    = instruction & reglist_bits;
+
+		if (instruction & arithmetic_bit)
+		{
+			d.type = DecodedInstruction::Type::ARITHMETIC;
+			d.op = (instruction & opcode_bits) >> 22;
+			d.handler = detail::arithmetic_handlers<BasicLittle32Core>[(d.op << 3) | (d.immediate << 2) | (d.set_status << 1) | d.negative];
+		}
+		else if (instruction & branch_bit)
+		{
+			d.type = DecodedInstruction::Type::BRANCH;
+
+			if (d.offset == 0 && d.negative)
+			{
+				d.handler = d.link ? &BasicLittle32Core::ReturnHandler : &BasicLittle32Core::ReturnFromInterruptHandler;
+			}
+			else if (d.offset == 0 && !d.link)
+			{
+				d.handler = &BasicLittle32Core::HaltHandler;
+			}
+			else
+			{
+				d.handler = d.link ? &BasicLittle32Core::BranchHandler<true> : &BasicLittle32Core::BranchHandler<false>;
+			}
+		}
+		else if (instruction & extended_bit)
+		{
+			d.type = DecodedInstruction::Type::EXTENDED;
+			d.op = (instruction & extended_op_bits) >> 20;
+			d.handler = detail::extended_handlers<BasicLittle32Core>[(d.op << 1) | d.negative];
+		}
+		else if (instruction & float_bit)
+		{
+			d.type = DecodedInstruction::Type::FLOAT;
+			d.op = (instruction & float_op_bits) >> 20;
+			d.handler = detail::float_handlers<BasicLittle32Core>[d.op];
+		}
+		else
+		{
+			d.handler = &BasicLittle32Core::NopHandler;
+		}
+
+		return d;
+	}
+
+	template<typename Memory>
+	const typename BasicLittle32Core<Memory>::DecodedInstruction& BasicLittle32Core<Memory>::Fetch(word address)
+	{
+		DecodedInstruction& d = decode_cache[(address / sizeof(word)) & (decode_cache_size - 1)];
+
+		if (d.valid && d.address == address) return d;
+
+		d = Decode(computer.Read(address));
+		d.address = address;
+		d.valid = true;
+
+		if (fuse_instructions) Fuse(d);
+
+		return d;
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::Fuse(DecodedInstruction& d)
+	{
+		using Type = DecodedInstruction::Type;
+
+		// Only unconditional arithmetic that doesn't write to PC starts a fused instruction
+		if (d.type != Type::ARITHMETIC || d.cond != AL || d.reg1 == 15) return;
+
+		// B or BL, but not RET or RFE
+		const auto IsBranch = [](const DecodedInstruction& b) { return b.type == Type::BRANCH && !(b.negative && b.offset == 0); };
+
+		const auto FuseBranch = [&](const DecodedInstruction& b, byte length)
+		{
+			d.offset = b.offset;
+			d.link = b.link;
+			d.fused_cond = b.cond;
+			d.length = length;
+		};
+
+		const DecodedInstruction next = Decode(computer.Read(d.address + sizeof(word)));
+
+		if (d.op == 0b0110 || d.op == 0b0111 || d.op == 0b1011) // CMP / CMN / TST, then B / BL
+		{
+			if (!IsBranch(next)) return;
+
+			const size_t compare = d.op == 0b0110 ? 0 : d.op == 0b0111 ? 1 : 2;
+			d.handler = detail::compare_branch_handlers<BasicLittle32Core>[(compare << 3) | (d.immediate << 2) | (d.negative << 1) | next.link];
+			FuseBranch(next, 2);
+		}
+		else if (d.op == 0b1110) // MOV Rn, label, then RRW Rn, [Rn]
+		{
+			if (d.set_status) return;
+			if (next.type != Type::EXTENDED || next.cond != AL || next.op != 0b1001) return;
+			if (next.reg1 != d.reg1 || next.reg2 != d.reg1 || next.imm8 != 0) return;
+
+			d.handler = detail::load_handlers<BasicLittle32Core>[(d.immediate << 1) | d.negative];
+			d.length = 2;
+		}
+		else if (d.op == 0b0000 || d.op == 0b0001) // INC / DEC Rn, then CMP Rn, then B / BL
+		{
+			if (!d.immediate || d.negative || d.reg2 != d.reg1) return;
+			if (next.type != Type::ARITHMETIC || next.cond != AL || next.op != 0b0110 || next.reg1 != d.reg1) return;
+
+			const DecodedInstruction last = Decode(computer.Read(d.address + 2 * sizeof(word)));
+
+			if (!IsBranch(last)) return;
+
+			// The amount to step by stays in imm8, while the comparison takes over the other operands
+			d.immediate = next.immediate;
+			d.negative = next.negative;
+			d.reg2 = next.reg2;
+			d.reg3 = next.reg3;
+			d.shift = next.shift;
+			d.imm12 = next.imm12;
+
+			d.handler = detail::loop_handlers<BasicLittle32Core>[(d.op << 3) | (d.immediate << 2) | (d.negative << 1) | last.link];
+			FuseBranch(last, 3);
+		}
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::InvalidateCache(word address, word range)
+	{
+		if (range >= decode_cache_size * sizeof(word)) return FlushCache();
+
+		// An instruction fetched from 'a' covers [a, a + 4 * length), so it is stale if it overlaps [address, address + range)
+		const word start = address - (max_fused_length * sizeof(word) - 1);
+		const word length = range + (max_fused_length * sizeof(word) - 1);
+		const word slots = ((start % sizeof(word)) + length + sizeof(word) - 1) / sizeof(word);
+
+		for (word i = 0, slot = start / sizeof(word); i < slots; i++, slot++)
+		{
+			DecodedInstruction& d = decode_cache[slot & (decode_cache_size - 1)];
+
+			if (d.valid && (d.address - address < range || address - d.address < d.length * sizeof(word))) d.valid = false;
+		}
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::FlushCache()
+	{
+		for (DecodedInstruction& d : decode_cache) d.valid = false;
+	}
+
+	template<typename Memory>
+	bool BasicLittle32Core<Memory>::IsHalted()
+	{
+		if (fused_cycles != 0) return false;
+
+		const DecodedInstruction& d = Fetch(PC);
+
+		// HALT is B 0, a branch to itself, and WFI stays put until it's interrupted.
+		// Their condition can't start failing, as nothing sets the flags while they spin
+		const bool halt = d.type == DecodedInstruction::Type::BRANCH && d.offset == 0 && !d.negative && !d.link;
+		const bool wait = d.type == DecodedInstruction::Type::EXTENDED && d.op == 0b0000;
+
+		if (!halt && !wait) return false;
+
+		return d.cond == AL || ((condition_masks[d.cond] >> GetFlags()) & 1) != 0;
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::Clock()
+	{
+		// Instructions fused into an earlier one have already run, but still take up their cycles
+		if (fused_cycles != 0)
+		{
+			fused_cycles--;
+			return;
+		}
+
+		// Memory writes during this instruction may invalidate d, but its fields stay intact until the next fetch
+		const DecodedInstruction& d = Fetch(PC);
+
+		// Skip to the next instruction if the condition fails
+		if (d.cond != AL && ((condition_masks[d.cond] >> GetFlags()) & 1) == 0)
+		{
+			PC += sizeof(word);
+			return;
+		}
+
+		(this->*d.handler)(d);
+	}
+
+	template<typename Memory>
+	word BasicLittle32Core<Memory>::Run(word budget)
+	{
+		run_cycles = 0;
+
+		while (run_cycles < budget)
+		{
+			// Instructions fused into an earlier one have already run, so their cycles are used up all at once
+			if (fused_cycles != 0)
+			{
+				const word n = std::min(fused_cycles, budget - run_cycles);
+				fused_cycles -= n;
+				run_cycles += n;
+				continue;
+			}
+
+			const DecodedInstruction& d = Fetch(PC);
+			run_cycles++;
+
+			if (d.cond != AL && ((condition_masks[d.cond] >> GetFlags()) & 1) == 0)
+			{
+				PC += sizeof(word);
+				continue;
+			}
+
+			(this->*d.handler)(d);
+
+			// The computer has to see a HALT to skip ahead, and anything scheduled by the instruction may be due before the budget runs out
+			if (computer.halted || computer.yield) break;
+		}
+
+		// The computer counts these itself once the run is over
+		const word ran = run_cycles;
+		run_cycles = 0;
+		return ran;
+	}
+
+	template<typename Memory>
+	template<byte op, bool immediate, bool set_status, bool negative>
+	void BasicLittle32Core<Memory>::ArithmeticHandler(const DecodedInstruction& d)
+	{
+		using namespace std;
+
+		constexpr int32_t inv = negative ? -1 : 1;    // 1 or -1:      Used for inverting values with *
+		constexpr word neg = negative ? ~(word)0 : 0; // all 0s or 1s: Used for inverting values with ^
+
+		word& reg1 = registers[d.reg1];
+		word& reg2 = registers[d.reg2];
+
+		      int32_t& reg1_int = reinterpret_cast<      int32_t&>(reg1);
+		const int32_t& reg2_int = reinterpret_cast<const int32_t&>(reg2);
+
+		// Flexible operands: a constant if immediate, otherwise a register put through the barrel shift
+		const auto Val2 = [&]() -> word { if constexpr (immediate) return d.imm12; else return rotl(reg2, d.shift); };
+		const auto Val3 = [&]() -> word { if constexpr (immediate) return d.imm8; else return rotl(registers[d.reg3], d.shift); };
+
+		if constexpr (op == 0b0000) // ADD          Add
+		{
+			const int32_t val3_int = Val3();
+			int64_t long_val;
+			reg1_int = long_val = ((int64_t)reg2_int + (int64_t)val3_int) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ARITHMETIC, reg1, (word)(long_val >> 32));
+			}
+		}
+		else if constexpr (op == 0b0001) // SUB          Sub
+		{
+			const int32_t val3_int = Val3();
+			int64_t long_val;
+			reg1_int = long_val = ((int64_t)reg2_int - (int64_t)val3_int) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ARITHMETIC, reg1, (word)(long_val >> 32));
+			}
+		}
+		else if constexpr (op == 0b0010) // ADC          Add with carry
+		{
+			const int32_t val3_int = Val3();
+			int64_t long_val;
+			const word flags = GetFlags();
+			const bool C = (flags & C_flag) != 0;
+			const bool NV = ((flags & N_flag) != 0) != ((flags & V_flag) != 0);
+			reg1_int = long_val = ((int64_t)reg2_int + (int64_t)val3_int + C * (1 - 2 * (int64_t)NV)) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ARITHMETIC, reg1, (word)(long_val >> 32));
+			}
+		}
+		else if constexpr (op == 0b0011) // SBB          Sub with borrow
+		{
+			const int32_t val3_int = Val3();
+			int64_t long_val;
+			const word flags = GetFlags();
+			const bool C = (flags & C_flag) != 0;
+			const bool NV = ((flags & N_flag) != 0) != ((flags & V_flag) != 0);
+			reg1_int = long_val = ((int64_t)reg2_int - (int64_t)val3_int + C * (1 - 2 * (int64_t)NV)) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ARITHMETIC, reg1, (word)(long_val >> 32));
+			}
+		}
+		else if constexpr (op == 0b0100) // ASL          Arithmetic shift left
+		{
+			const word val3 = Val3();
+			reg1 = (reg2 << val3) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ASL, reg1, reg2, val3, negative);
+			}
+		}
+		else if constexpr (op == 0b0101) // ASR          Arithmetic shift right
+		{
+			const word val3 = Val3();
+			reg1 = ((reg2 >> val3) | ~(~(word)0 >> val3)) * inv;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::ASR, reg1, reg2, val3, negative);
+			}
+		}
+		else if constexpr (op == 0b0110) // CMP          Compare two values with -
+		{
+			const int32_t val2_int = Val2();
+			int64_t long_val;
+			int32_t val;
+			val = long_val = ((int64_t)reg1_int - (int64_t)val2_int) * inv;
+
+			DeferFlags(FlagOp::ARITHMETIC, val, (word)(long_val >> 32));
+		}
+		else if constexpr (op == 0b0111) // CMN          Compare two values with +
+		{
+			const int32_t val2_int = Val2();
+			int64_t long_val;
+			int32_t val;
+			val = long_val = ((int64_t)reg1 + (int64_t)val2_int) * inv;
+
+			DeferFlags(FlagOp::CMN, val, (word)(long_val >> 32));
+		}
+		else if constexpr (op == 0b1000) // ORR          A | B
+		{
+			reg1 = (reg2 | Val3()) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::LOGIC, reg1);
+			}
+		}
+		else if constexpr (op == 0b1001) // AND          A & B
+		{
+			reg1 = (reg2 & Val3()) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::LOGIC, reg1);
+			}
+		}
+		else if constexpr (op == 0b1010) // XOR          A ^ B
+		{
+			reg1 = (reg2 ^ Val3()) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::LOGIC, reg1);
+			}
+		}
+		else if constexpr (op == 0b1011) // TST          Test bits with &
+		{
+			const int32_t val = reg1 & (Val2() ^ neg);
+
+			DeferFlags(FlagOp::LOGIC, val);
+		}
+		else if constexpr (op == 0b1100) // LSL          Logical shift left
+		{
+			const word val3 = Val3();
+			reg1 = (reg2 << val3) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::LSL, reg1, reg2, val3, negative);
+			}
+		}
+		else if constexpr (op == 0b1101) // LSR          Logical shift right
+		{
+			const word val3 = Val3();
+			reg1 = (reg2 >> val3) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::LSR, reg1, reg2, val3, negative);
+			}
+		}
+		else if constexpr (op == 0b1110) // MOV / MVN    Copy value to register
+		{
+			const word val2 = Val2();
+			const int32_t val = reg1_int;
+			reg1 = val2 ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::MOVE, reg1, val);
+			}
+		}
+		else if constexpr (op == 0b1111) // INV          -A
+		{
+			const word val2 = Val2();
+			const int32_t val = reg1_int;
+			reg1 = (~val2 + 1) ^ neg;
+
+			if constexpr (set_status)
+			{
+				DeferFlags(FlagOp::MOVE, reg1, val);
+			}
+		}
+
+		PC += sizeof(word); // Moves to the next word
+	}
+
+	template<typename Memory>
+	template<bool link>
+	void BasicLittle32Core<Memory>::BranchHandler(const DecodedInstruction& d) // B / BL
+	{
+		if constexpr (link) LR = PC + sizeof(word); // BL
+		PC += d.offset;
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::HaltHandler(const DecodedInstruction&) // HALT
+	{
+		// Branches to itself, so PC stays where it is
+		computer.halted = true;
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::ReturnHandler(const DecodedInstruction&) // RET
+	{
+		PC = LR;
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::ReturnFromInterruptHandler(const DecodedInstruction&) // RFE
+	{
+		computer.interrupts.Return(SP);
+
+		// Banks are only used from the outermost handler in, so the innermost handler is the last to have pushed
+		if (unbanked_depth == 0 && bank_depth != 0)
+		{
+			const RegisterBank& bank = banks[--bank_depth];
+
+			// R0-R12 and LR. The handler has already put SP back if it's going to
+			for (word i = 0; i < 15; i++)
+			{
+				if (i != 13 && (banked_registers >> i) & 1) registers[i] = bank.registers[i];
+			}
+
+			PC = bank.registers[15];
+			SetFlags(bank.flags);
+			return;
+		}
+
+		if (unbanked_depth != 0) unbanked_depth--;
+
+		PC = Pop(SP);
+		SetFlags(Pop(SP));
+	}
+
+	template<typename Memory>
+	template<byte op, bool negative>
+	void BasicLittle32Core<Memory>::ExtendedHandler(const DecodedInstruction& d)
+	{
+		using namespace std;
+
+		constexpr int32_t inv = negative ? -1 : 1;
+
+		word& reg1 = registers[d.reg1];
+		word& reg2 = registers[d.reg2];
+
+		if constexpr (op >= 0b1000)
+		{
+			// Odd opcodes use an immediate offset
+			const int32_t off = (op & 1) ? d.imm8 * inv : rotl(registers[d.reg3], d.shift) * inv;
+			const word addr = reg2 + off;
+
+			if constexpr (op == 0b1000 || op == 0b1001) reg1 = computer.Read(addr);         // RRW
+			if constexpr (op == 0b1010 || op == 0b1011) computer.Write(addr, reg1);         // RWW
+			if constexpr (op == 0b1100 || op == 0b1101) reg1 = computer.ReadByte(addr);     // RRB
+			if constexpr (op == 0b1110 || op == 0b1111) computer.WriteByte(addr, reg1);     // RWB
+		}
+		else if constexpr (op == 0b0100) // SRR
+		{
+			if (d.reglist & (1 << d.reg1))
+			{
+				// Popping into the stack pointer itself has to happen in order
+				for (word i = 16; i--;)
+				{
+					if (d.reglist & (1 << i)) registers[i] = Pop(reg1) * inv;
+				}
+			}
+			else
+			{
+				// The registers are stacked in one block, the highest register at the lowest address
+				word values[16];
+				const word count = popcount(d.reglist);
+				computer.ReadBlock(reg1, values, count);
+				reg1 += count * sizeof(word);
+
+				word k = 0;
+				for (word i = 16; i--;)
+				{
+					if (d.reglist & (1 << i)) registers[i] = values[k++] * inv;
+				}
+			}
+		}
+		else if constexpr (op == 0b0101) // SWR
+		{
+			if (d.reglist & (1 << d.reg1))
+			{
+				// The stack pointer pushes the value it has part way through
+				for (word i = 0; i < 16; i++)
+				{
+					if (d.reglist & (1 << i)) Push(reg1, registers[i] * inv);
+				}
+			}
+			else
+			{
+				word values[16];
+				const word count = popcount(d.reglist);
+
+				word k = count;
+				for (word i = 0; i < 16; i++)
+				{
+					if (d.reglist & (1 << i)) values[--k] = registers[i] * inv;
+				}
+
+				reg1 -= count * sizeof(word);
+				computer.WriteBlock(reg1, values, count);
+			}
+		}
+		else if constexpr (op == 0b0110) // MVM
+		{
+			const word v = reg1 * inv;
+			for (word i = 0; i < 16; i++)
+			{
+				if (d.reglist & (1 << i)) registers[i] = v;
+			}
+		}
+		else if constexpr (op == 0b0111) // SWP
+		{
+			reg2 = rotl(reg2, d.shift) * inv;
+			swap(reg1, reg2);
+		}
+		else if constexpr (op == 0b0000) // WFI
+		{
+			// Spins in place like HALT, until an interrupt moves past it
+			waiting = true;
+			computer.halted = true;
+			return;
+		}
+		// 0b0001 - 0b0011: Room for more instructions?
+
+		PC += sizeof(word); // Moves to the next word
+	}
+
+	template<typename Memory>
+	template<byte op>
+	void BasicLittle32Core<Memory>::FloatHandler(const DecodedInstruction& d) // FPU
+	{
+		using namespace std;
+
+		// Not a constant, as the compiler would turn * -1 into flipping the sign bit, which changes the sign of NaNs
+		const int32_t inv = d.negative ? -1 : 1;
+
+		word& reg1 = registers[d.reg1];
+		word& reg2 = registers[d.reg2];
+
+		const word reg2s = rotl(reg2, d.shift);
+		const word reg3s = rotl(registers[d.reg3], d.shift);
+
+		      int32_t& reg1_int  = reinterpret_cast<      int32_t&>(reg1 );
+		const int32_t& reg2s_int = reinterpret_cast<const int32_t&>(reg2s);
+
+		      float& reg1f  = reinterpret_cast<      float&>(reg1);
+		const float& reg2f  = reinterpret_cast<const float&>(reg2 );
+		const float& reg2sf = reinterpret_cast<const float&>(reg2s);
+		const float& reg3f  = reinterpret_cast<const float&>(reg3s);
+
+		if constexpr (op == 0b000) // ADDF
+		{
+			reg1f = (reg2f + reg3f) * inv;
+		}
+		else if constexpr (op == 0b001) // SUBF
+		{
+			reg1f = (reg2f - reg3f) * inv;
+		}
+		else if constexpr (op == 0b010) // MULF
+		{
+			reg1f = (reg2f * reg3f) * inv;
+		}
+		else if constexpr (op == 0b011) // DIVF
+		{
+			reg1f = (reg2f / reg3f) * inv;
+		}
+		else if constexpr (op == 0b100) // ITOF
+		{
+			reg1f = (float)(reg2s_int * inv);
+		}
+		else if constexpr (op == 0b101) // FTOI
+		{
+			reg1_int = (int32_t)(reg2sf * inv);
+		}
+		else if constexpr (op == 0b110) // CMPF
+		{
+			const float cmp = (reg1f - reg2sf) * inv;
+			const bool V = (reg1f < 0.f) != (reg2sf < 0.f) && std::abs(reg2sf) > std::numeric_limits<float>::max() - std::abs(reg1f);
+			SetFlags((cmp < 0.f) * N_flag | (cmp == 0.f) * Z_flag | V * V_flag);
+		}
+		else if constexpr (op == 0b111) // CMPFI
+		{
+			const float cmp = (reg1f - reg2s_int) * inv;
+			const bool V = (reg1f < 0.f) != (reg2s_int < 0.f) && std::abs(reg2s_int) > std::numeric_limits<float>::max() - std::abs(reg1f);
+			SetFlags((cmp < 0.f) * N_flag | (cmp == 0.f) * Z_flag | V * V_flag);
+		}
+
+		PC += sizeof(word); // Moves to the next word
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::NopHandler(const DecodedInstruction&)
+	{
+		PC += sizeof(word); // Moves to the next word
+	}
+
+	template<typename Memory>
+	template<byte op, bool immediate, bool negative, bool link>
+	void BasicLittle32Core<Memory>::CompareBranchHandler(const DecodedInstruction& d) // CMP / CMN / TST, then B / BL
+	{
+		ArithmeticHandler<op, immediate, false, negative>(d);
+
+		if ((condition_masks[d.fused_cond] >> GetFlags()) & 1) BranchHandler<link>(d);
+		else PC += sizeof(word);
+
+		fused_cycles += 1;
+		fusion_counts[(size_t)Fusion::COMPARE_BRANCH]++;
+	}
+
+	template<typename Memory>
+	template<bool immediate, bool negative>
+	void BasicLittle32Core<Memory>::LoadHandler(const DecodedInstruction& d) // MOV Rn, label, then RRW Rn, [Rn]
+	{
+		ArithmeticHandler<0b1110, immediate, false, negative>(d);
+
+		registers[d.reg1] = computer.Read(registers[d.reg1]);
+		PC += sizeof(word);
+
+		fused_cycles += 1;
+		fusion_counts[(size_t)Fusion::LOAD]++;
+	}
+
+	template<typename Memory>
+	template<byte op, bool immediate, bool negative, bool link>
+	void BasicLittle32Core<Memory>::LoopHandler(const DecodedInstruction& d) // INC / DEC Rn, then CMP Rn, then B / BL
+	{
+		if constexpr (op == 0b0000) registers[d.reg1] += d.imm8; // INC
+		else                        registers[d.reg1] -= d.imm8; // DEC
+		PC += sizeof(word);
+
+		ArithmeticHandler<0b0110, immediate, false, negative>(d);
+
+		if ((condition_masks[d.fused_cond] >> GetFlags()) & 1) BranchHandler<link>(d);
+		else PC += sizeof(word);
+
+		fused_cycles += 2;
+		fusion_counts[(size_t)Fusion::LOOP]++;
+	}
+
+	template<typename Memory>
+	const std::string BasicLittle32Core<Memory>::Disassemble(word instruction) const
+	{
+		using namespace std;
+
+		const byte c = ( instruction & cond_bits ) >> 28;
+		const string cond = c == 0 ? " " : string(CONDITION_NAMES[c]) + " ";
+		const string cond2 = c == 0 ? "" : " ?" + string(CONDITION_NAMES[c]);
+
+		const bool negative = ( instruction & negative_bit ) != 0;
+		const bool immediate = ( instruction & immediate_bit ) != 0;
+		const bool set_status = ( instruction & status_bit ) != 0;
+		const bool link = ( instruction & link_bit ) != 0;
+
+		const char* const sign = negative ? "-" : "+";
+		const string nstr = negative ? "N" : "";
+		const string sstr = set_status ? "S" : "";
+
+		const byte shift = ( instruction & shift_bits ) * 2;
+		const string shstr = shift == 0 ? "" : ( " << " + to_string(shift) );
+
+		const word   imm8_v = rotl(( instruction & imm8_bits ) >> 4, shift);
+		const word   imm12_v = rotl(( instruction & imm12_bits ) >> 4, shift);
+		const string imm8 = to_string(imm8_v);
+		const string imm12 = to_string(imm12_v);
+		const string reg_list = RegListToString(instruction & reglist_bits);
+		const word   b_off_v = ( instruction & offset_bits ) * sizeof(word);
+		const string b_off = sign + to_string(b_off_v);
+
+		const string r1 = REGISTER_NAMES[( instruction & reg1_bits ) >> 16];
+		const string r2 = REGISTER_NAMES[( instruction & reg2_bits ) >> 12];
+		const string r3 = REGISTER_NAMES[( instruction & reg3_bits ) >> 8];
+
+		if (instruction & arithmetic_bit) // Arithmetic
+		{
+			const string& val2 = immediate ? imm12 : r2;
+			const string& val3 = immediate ? imm8 : r3;
+
+			const string& val2b = immediate ? "0b" + ToBinary(imm12_v, 0) : r2;
+			const string& val3b = immediate ? "0b" + ToBinary(imm8_v, 0) : r3;
+
+			switch (( instruction & opcode_bits ) >> 22)
+			{
+			case 0b0000: return nstr + "ADD" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0001: return nstr + "SUB" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0010: return nstr + "ADC" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0011: return nstr + "SBB" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0100: return nstr + "ASL" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0101: return nstr + "ASR" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b0110: return nstr + "CMP " + r1 + ", " + val2 + cond2;
+			case 0b0111: return nstr + "CMN " + r1 + ", " + val2 + cond2;
+			case 0b1000: return ( negative ? "NOR" : "ORR" ) + sstr + " " + r1 + ", " + r2 + ", " + val3b + cond2;
+			case 0b1001: return nstr + "AND" + sstr + " " + r1 + ", " + r2 + ", " + val3b + cond2;
+			case 0b1010: return "X" + nstr + "OR" + sstr + " " + r1 + ", " + r2 + ", " + val3b + cond2;
+			case 0b1011: return nstr + "TST " + r1 + ", " + val2b + cond2;
+			case 0b1100: return nstr + "LSL" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b1101: return nstr + "LSR" + sstr + " " + r1 + ", " + r2 + ", " + val3 + cond2;
+			case 0b1110: return ( negative ? "MVN" : "MOV" ) + sstr + " " + r1 + ", " + val2 + cond2;
+			case 0b1111: return nstr + "INV" + sstr + " " + r1 + ", " + val2 + cond2;
+			}
+		}
+
+		if (instruction & branch_bit)
+		{
+			if (negative && b_off_v == 0)
+			{
+				if (link) return "RET" + cond2; // RET
+				else      return "RFE" + cond2; // RFE
+			}
+			else
+			{
+				if (link) return "BL " + b_off + cond2; // BL
+				else if (b_off_v == 0) return "HALT" + cond2;
+				else      return "B" + cond + b_off; // B
+			}
+		}
+		else if (instruction & extended_bit)
+		{
+
+			const string addr = r2 == "PC" ? sign : r2 + " " + sign + " ";
+
+			switch (( instruction & extended_op_bits ) >> 20)
+			{
+			case 0b1000: return nstr + "RRW " + r1 + ", [" + addr + r3 + shstr + "]" + cond2;
+			case 0b1001: return nstr + "RRW " + r1 + ", [" + addr + imm8 + "]" + cond2;
+			case 0b1010: return nstr + "RWW " + r1 + ", [" + addr + r3 + shstr + "]" + cond2;
+			case 0b1011: return nstr + "RWW " + r1 + ", [" + addr + imm8 + "]" + cond2;
+			case 0b1100: return nstr + "RRB " + r1 + ", [" + addr + r3 + shstr + "]" + cond2;
+			case 0b1101: return nstr + "RRB " + r1 + ", [" + addr + imm8 + "]" + cond2;
+			case 0b1110: return nstr + "RWB " + r1 + ", [" + addr + r3 + shstr + "]" + cond2;
+			case 0b1111: return nstr + "RWB " + r1 + ", [" + addr + imm8 + "]" + cond2;
+			case 0b0100: return nstr + "SRR " + r1 + ", " + reg_list + cond2;
+			case 0b0101: return nstr + "SWR " + r1 + ", " + reg_list + cond2;
+			case 0b0110: return nstr + "MVM " + r1 + ", " + reg_list + cond2;
+			case 0b0111: return nstr + "SWP " + r1 + ", " + r2 + shstr + cond2;
+			case 0b0000: return "WFI" + cond2;
+			case 0b0010: // Room for more instructions?
+			case 0b0011:
+			case 0b0001:
+				return "";
+			}
+		}
+		else if (instruction & float_bit)
+		{ // FPU
+			switch (( instruction & float_op_bits ) >> 20)
+			{
+			case 0: return nstr + "ADDF " + r1 + ", " + r2 + ", " + r3 + cond2;
+			case 1: return nstr + "SUBF " + r1 + ", " + r2 + ", " + r3 + cond2;
+			case 2: return nstr + "MULF " + r1 + ", " + r2 + ", " + r3 + cond2;
+			case 3: return nstr + "DIVF " + r1 + ", " + r2 + ", " + r3 + cond2;
+			case 4: return nstr + "ITOF " + r1 + ", " + r2 + cond2;
+			case 5: return nstr + "FTOI " + r1 + ", " + r2 + cond2;
+			case 6: return nstr + "CMPF " + r1 + ", " + r2 + cond2;
+			case 7: return nstr + "CMPFI " + r1 + ", " + r2 + cond2;
+			}
+		}
+
+		return "";
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::Reset()
+	{
+		memset(registers, 0, sizeof(registers));
+		SetFlags(0);
+		fused_cycles = 0;
+		waiting = false;
+		bank_depth = 0;
+		unbanked_depth = 0;
+		FlushCache();
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::Interrupt(word address)
+	{
+		// Returns to the instruction after WFI
+		if (waiting)
+		{
+			PC += sizeof(word);
+			waiting = false;
+		}
+
+		if (bank_depth < register_banks)
+		{
+			RegisterBank& bank = banks[bank_depth++];
+			memcpy(bank.registers, registers, sizeof(registers));
+			bank.flags = GetFlags();
+		}
+		else
+		{
+			if (register_banks != 0) unbanked_depth++;
+
+			Push(SP, GetFlags());
+			Push(SP, PC);
+		}
+
+		PC = address;
+		SetFlags(0);
+
+		computer.NotifyInterrupt();
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::SetFlags(word flags)
+	{
+		flag_op = FlagOp::PACKED;
+		flag_result = flags & (N_flag | Z_flag | C_flag | V_flag);
+	}
+
+	template<typename Memory>
+	void BasicLittle32Core<Memory>::Push(word& ptr, word val)
+	{
+		ptr -= sizeof(word);
+		computer.Write(ptr, val);
+	}
+
+	template<typename Memory>
+	word BasicLittle32Core<Memory>::Pop(word& ptr)
+	{
+		ptr += sizeof(word);
+		return computer.Read(ptr - sizeof(word));
+	}
+}
+
+#endif
\ No newline at end of file
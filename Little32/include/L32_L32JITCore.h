@@ -0,0 +1,117 @@
+#pragma once
+
+#ifndef L32_L32JITCore_h_
+#define L32_L32JITCore_h_
+
+#include "L32_L32Core.h"
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Native code generation is only available when the host is x86-64
+#if defined(_M_X64) || defined(__x86_64__)
+#define L32_JIT_SUPPORTED 1
+#else
+#define L32_JIT_SUPPORTED 0
+#endif
+
+namespace Little32
+{
+	/// <summary>
+	/// A Little32 core that translates basic blocks of guest code into x86-64 code.
+	/// Common arithmetic, branches, loads and stores are translated directly, while everything else is handed to the interpreter.
+	/// A run stops early when the computer asks it to, e.g. because a device was scheduled sooner. Translated code checks for this whenever it calls out to the computer,
+	/// so it stops after the instruction that asked, as the interpreter does.
+	/// </summary>
+	struct Little32JITCore : public Little32Core
+	{
+		/// <summary> A direct jump out of a block to a fixed address, which can be patched to go straight to the next block </summary>
+		struct BlockExit
+		{
+			byte* patch_site = nullptr;
+			word target = 0;
+		};
+
+		struct Block
+		{
+			word address = 0;
+			word length = 0; // In instructions
+			byte* code = nullptr;
+		};
+
+		/// <summary> RAM or ROM that no other device overlaps, which translated code can access directly </summary>
+		struct MemoryRegion
+		{
+			word start = 0;
+			word size = 0;
+			byte* memory = nullptr;
+			bool writable = false;
+			/// <summary> The RAM's record of which of its pages were written since it was reset </summary>
+			const byte* dirty_pages = nullptr;
+			/// <summary> One entry per page of the region, non-zero if translated code came from that page </summary>
+			std::vector<byte> code_map;
+		};
+
+		// Size of the pages used to track which memory has been translated
+		static constexpr word code_page_bits = 10;
+		// The most instructions translated into a single block
+		static constexpr word max_block_length = 64;
+		// Size of the buffer holding generated code
+		static constexpr size_t code_buffer_size = 4 * 1024 * 1024;
+		// Must be a power of 2
+		static constexpr word block_lookup_size = 4096;
+
+		byte* code_buffer = nullptr;
+		byte* code_start = nullptr; // After the entry and exit trampolines
+		byte* code_current = nullptr;
+
+		void (*enter_code)(byte* code) = nullptr;
+		byte* exit_code = nullptr;
+
+		std::unordered_map<word, Block> blocks;
+		std::vector<Block*> block_lookup;
+		std::deque<BlockExit> block_exits;
+		std::vector<MemoryRegion> regions;
+		std::unordered_set<word> code_pages;
+
+		// State shared with generated code
+		word jit_flags = 0;
+		int64_t jit_budget = 0;
+		/// <summary> What jit_budget started the run at, so how far the run has got can be told between blocks </summary>
+		word jit_run_budget = 0;
+		BlockExit* last_exit = nullptr;
+
+		bool flush_pending = true;
+		bool code_modified = false;
+
+
+		Little32JITCore(Computer& computer);
+		~Little32JITCore();
+
+		void InvalidateCache(word address, word range);
+		void FlushCache();
+
+		/// <summary> Runs up to budget instructions, translating code as it goes </summary>
+		word Run(word budget);
+
+		/// <summary> Exact whenever translated code calls out to the computer, as the budget is stored for it first. Otherwise only counts whole blocks </summary>
+		inline word CyclesRun() const { return run_cycles + (word)(jit_run_budget - jit_budget); }
+
+	private:
+		void EmitTrampolines();
+		void FlushBlocks();
+		void CollectRegions();
+		Block* FindBlock(word address);
+		Block* Compile(word address);
+
+		static word ReadHelper(Little32JITCore* core, word address);
+		static word ReadByteHelper(Little32JITCore* core, word address);
+		static word WriteHelper(Little32JITCore* core, word address, word value);
+		static word WriteByteHelper(Little32JITCore* core, word address, word value);
+		static word InterpretHelper(Little32JITCore* core, word address, word flags);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef L32_L32Recompiler_h_
+#define L32_L32Recompiler_h_
+
+#include "L32_L32Core.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Little32
+{
+	struct Computer;
+
+	/// <summary>
+	/// Recompiles the code in ROM ahead of time into a C++ translation unit, with one function per basic block.
+	/// The unit only needs the include directory, and is built into a shared library that Little32AOTCore loads, e.g.
+	/// "cl /O2 /LD /std:c++20 /I include program.cpp" or "g++ -O2 -shared -fPIC -std=c++20 -I include program.cpp -o program.so".
+	/// Anything that isn't translated, such as RFE, floats and writes to PC, is left to the interpreter.
+	/// </summary>
+	struct Little32Recompiler
+	{
+		/// <summary> A basic block found in ROM </summary>
+		struct Block
+		{
+			word address = 0;
+			std::vector<word> code;
+			std::vector<Little32Core::DecodedInstruction> instructions;
+		};
+
+		// The most instructions recompiled into a single block
+		static constexpr word max_block_length = 256;
+
+		word rom_start = 0;
+		word rom_size = 0;
+
+		/// <summary> Addresses that code is known to start at, besides the start of ROM and the targets of branches </summary>
+		std::vector<word> entry_points;
+
+		/// <summary> The blocks found by the last call to FindBlocks, by address </summary>
+		std::map<word, Block> blocks;
+
+		constexpr void SetROM(word start_address, word size)
+		{
+			rom_start = start_address;
+			rom_size = size;
+		}
+
+		/// <summary> Follows the code in ROM from every entry point, splitting it into basic blocks </summary>
+		void FindBlocks(Computer& computer);
+
+		/// <summary> Finds the blocks in ROM, and writes the translation unit for them </summary>
+		void Recompile(Computer& computer, std::ostream& out);
+
+	private:
+		bool InROM(word address) const;
+		static std::string Translate(const Little32Core::DecodedInstruction& d, word count, bool& ends_block);
+	};
+}
+
+#endif
\ No newline at end of file
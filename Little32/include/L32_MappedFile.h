@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef L32_MappedFile_h_
+#define L32_MappedFile_h_
+
+#include "L32_Types.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace Little32
+{
+	/// <summary>
+	/// A host file mapped into memory, so that it's read a page at a time as it's used rather than copied up front.
+	/// Pages that haven't been written are shared with every other process mapping the same file.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		enum class Mode
+		{
+			/// <summary> Writes stay private to this mapping and never reach the file </summary>
+			COPY_ON_WRITE,
+			/// <summary> Writes go to the file, which is extended to the size of the mapping if it's too short </summary>
+			SHARED
+		};
+
+		/// <param name="path">The file to map</param>
+		/// <param name="size">The number of bytes to map. Must be no larger than the file when copying on write</param>
+		/// <param name="mode">Whether writes reach the file</param>
+		/// <exception cref="std::runtime_error">Thrown when the file can't be opened or mapped</exception>
+		MappedFile(const std::filesystem::path& path, size_t size, Mode mode);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		inline word* GetData() const { return data; }
+		inline size_t GetSize() const { return size; }
+		inline Mode GetMode() const { return mode; }
+
+		/// <summary> Writes pages that were changed back to the file. Does nothing unless the mapping is shared </summary>
+		/// <param name="wait">Whether to wait for the writes to finish, rather than just starting them</param>
+		void Flush(bool wait = false);
+
+		/// <summary> Maps a file as memory for a device. The file stays mapped for as long as the memory is used </summary>
+		/// <exception cref="std::runtime_error">Thrown when the file can't be opened or mapped</exception>
+		static std::shared_ptr<word[]> Map(const std::filesystem::path& path, size_t size, Mode mode);
+
+	private:
+		word* data = nullptr;
+		size_t size = 0;
+		Mode mode;
+
+#ifdef _WIN32
+		void* file_handle = nullptr;
+		void* mapping_handle = nullptr;
+#endif
+	};
+}
+
+#endif
\ No newline at end of file
@@ -3,24 +3,60 @@
 #ifndef L32_RAM_h_
 #define L32_RAM_h_
 
+#include "L32_Computer.h"
 #include "L32_IDeviceFactory.h"
 #include "L32_IMappedDevice.h"
 
 #include <memory>
+#include <vector>
 
 namespace Little32
 {
-	struct Computer;
+	class MappedFile;
 
 	/// <summary>Read-Write memory device</summary>
 	class RAM : public IMappedDevice
 	{
 	private:
-		void _WriteWordUnsafe(word address, word value);
-		void _WriteByteUnsafe(word address, byte value);
-
-		word _ReadWordUnsafe(word address);
-		byte _ReadByteUnsafe(word address);
+		inline void _MarkDirty(word address)
+		{
+			byte& dirty = dirty_pages[address >> dirty_page_bits];
+			if (dirty) return;
+
+			dirty = 1;
+			dirty_list.push_back(address >> dirty_page_bits);
+		}
+
+		void _MarkDirtyRange(word address, word size);
+
+		inline void _WriteWordUnsafe(word address, word value)
+		{
+			if (address % sizeof(word) == 0)
+			{
+				memory[address / sizeof(word)] = value;
+			}
+			else
+			{
+				const word x = (address % sizeof(word)) * 8;
+
+				memory[(address / sizeof(word)) + 0] &= (1 << x) - 1;
+				memory[(address / sizeof(word)) + 0] |= value << x;
+
+				memory[(address / sizeof(word)) + 1] &= (1 >> (32 - x)) - 1;
+				memory[(address / sizeof(word)) + 1] |= value >> (32 - x);
+			}
+		}
+
+		inline void _WriteByteUnsafe(word address, byte value)
+		{
+			word x = (address % sizeof(word)) * 8;
+
+			value ^= memory[address / sizeof(word)] >> x;
+			memory[address / sizeof(word)] ^= value << x;
+		}
+
+		inline word _ReadWordUnsafe(word address) { return memory[address / sizeof(word)]; }
+		inline byte _ReadByteUnsafe(word address) { return memory[address / sizeof(word)] >> ((address % sizeof(word)) * 8); }
 
 	public:
 		/// <summary> The start address of this RAM </summary>
@@ -29,25 +65,77 @@ namespace Little32
 		word address_size = 0;
 		/// <summary> The data used to fill memory when the device is reset </summary>
 		std::shared_ptr<word[]> default_memory;
+		/// <summary> Fills memory when the device is reset, if there's no default memory </summary>
+		byte default_byte = 0;
 		std::shared_ptr<word[]> memory;
 
+		// Only the pages written since the last reset are restored, so that resetting costs as much as the program wrote
+		static constexpr word dirty_page_bits = 12;
+		static constexpr word dirty_page_size = 1 << dirty_page_bits;
+
+		/// <summary> One entry per page, non-zero if it's been written since the last reset </summary>
+		std::unique_ptr<byte[]> dirty_pages;
+		/// <summary> Every page written since the last reset </summary>
+		std::vector<word> dirty_list;
+
+		/// <summary> The host file memory is mapped from, if any. It keeps its contents through resets, like battery backed memory </summary>
+		std::shared_ptr<MappedFile> backing_file;
+		/// <summary> The computer flushing the backing file every so often, and the interval it does it with, which is removed along with the RAM </summary>
+		Computer* flush_computer = nullptr;
+		std::shared_ptr<Computer::Interval> flush_interval = nullptr;
+
 		RAM(word address, word size, std::shared_ptr<word[]>& memory);
 		RAM(word address, word size, char default_byte = 0);
-
-		void Write(word address, word value);
-		void WriteByte(word address, byte value);
+		RAM(word address, word size, const std::shared_ptr<MappedFile>& backing_file);
+		~RAM();
 
 		void WriteForced(word address, word value);
 		void WriteByteForced(word address, byte value);
 
-		word Read(word address);
-		byte ReadByte(word address);
+		// Defined here so that callers that know the device type can inline them
+
+		inline void Write(word address, word value)
+		{
+			if (address + 3 >= address_size) return;
+
+			_MarkDirty(address);
+			return address % sizeof(word) ? _WriteByteUnsafe(address, value) : _WriteWordUnsafe(address, value);
+		}
+
+		inline void WriteByte(word address, byte value)
+		{
+			if (address >= address_size) return;
+
+			_MarkDirty(address);
+			return _WriteByteUnsafe(address, value);
+		}
+
+		inline word Read(word address)
+		{
+			if (address >= address_size) return 0;
+
+			return address % sizeof(word) ? _ReadByteUnsafe(address) : _ReadWordUnsafe(address);
+		}
+
+		inline byte ReadByte(word address)
+		{
+			if (address >= address_size) return 0;
+
+			return _ReadByteUnsafe(address);
+		}
+
+		void ReadBlock(word address, word* values, word count);
+		void WriteBlock(word address, const word* values, word count);
+		void WriteBlockForced(word address, const word* values, word count);
+		void Fill(word address, word value, word count);
+		void FillForced(word address, word value, word count);
 
 		inline word GetAddress() const { return address_start; }
 		inline word GetRange() const { return address_size; }
 
 		constexpr const Device_ID GetID() const { return RAM_DEVICE; }
 
+		/// <summary> Restores the pages that were written since the last reset </summary>
 		void Reset();
 	};
 
@@ -17,8 +17,8 @@ namespace Little32
 		void _WriteWordUnsafe(word address, word value);
 		void _WriteByteUnsafe(word address, byte value);
 
-		word _ReadWordUnsafe(word address);
-		byte _ReadByteUnsafe(word address);
+		inline word _ReadWordUnsafe(word address) { return memory[address / sizeof(word)]; }
+		inline byte _ReadByteUnsafe(word address) { return memory[address / sizeof(word)] >> ((address % sizeof(word)) * 8); }
 
 	public:
 		/// <summary> The start address of this ROM </summary>
@@ -26,14 +26,38 @@ namespace Little32
 		/// <summary> The size of this ROM in bytes </summary>
 		word address_size = 0;
 		std::shared_ptr<word[]> memory;
+		/// <summary> Whether memory is still as it was mapped from a file or the image cache, so there's nothing for Share to do </summary>
+		bool shared = false;
 
 		ROM(word address, word size, std::shared_ptr<word[]>& memory);
 		ROM(word address, word size, char default_byte = 0);
 
-		word Read(word address);
-		byte ReadByte(word address);
+		// Defined here so that callers that know the device type can inline them
+
+		inline word Read(word address)
+		{
+			if (address >= address_size) return 0;
+
+			return address % sizeof(word) ? _ReadByteUnsafe(address) : _ReadWordUnsafe(address);
+		}
+
+		inline byte ReadByte(word address)
+		{
+			if (address >= address_size) return 0;
+
+			return _ReadByteUnsafe(address);
+		}
+
 		void WriteForced(word address, word value);
 		void WriteByteForced(word address, byte value);
+
+		void ReadBlock(word address, word* values, word count);
+		void WriteBlockForced(word address, const word* values, word count);
+		void FillForced(word address, word value, word count);
+
+		/// <summary> Swaps memory for a copy of it from the image cache, so computers holding the same ROM share one copy of it. Does nothing while it's already shared </summary>
+		void Share();
+
 		inline word GetAddress() const { return address_start; }
 		inline word GetRange() const { return address_size; }
 		constexpr const Device_ID GetID() const { return ROM_DEVICE; }
@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef L32_SparseRAM_h_
+#define L32_SparseRAM_h_
+
+#include "L32_IMappedDevice.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace Little32
+{
+	/// <summary>
+	/// Read-Write memory that only allocates a page once something is written to it, for large RAM that is mostly untouched.
+	/// Pages that were never written read as the default byte. Behaves the same as RAM otherwise.
+	/// </summary>
+	class SparseRAM : public IMappedDevice
+	{
+	public:
+		static constexpr word page_bits = 12;
+		static constexpr word page_size = 1 << page_bits;
+		static constexpr word page_words = page_size / sizeof(word);
+
+	private:
+		/// <summary> Returns the page holding address, allocating it if it hasn't been written to yet </summary>
+		word* _CommitPage(word address);
+
+		inline word* _FindPage(word address) const { return pages[address >> page_bits].get(); }
+
+		inline word _ReadWordUnsafe(word address) const
+		{
+			const word* const page = _FindPage(address);
+			return page == nullptr ? default_word : page[(address % page_size) / sizeof(word)];
+		}
+
+		inline byte _ReadByteUnsafe(word address) const { return _ReadWordUnsafe(address & ~(word)(sizeof(word) - 1)) >> ((address % sizeof(word)) * 8); }
+
+		void _WriteByteUnsafe(word address, byte value);
+
+		/// <summary> Splits a block of words where it crosses into another page </summary>
+		template<typename F>
+		inline void _ForEachPage(word address, word count, F f)
+		{
+			for (word i = 0; i < count;)
+			{
+				const word n = std::min<word>(count - i, (page_size - address % page_size) / sizeof(word));
+
+				f(address, i, n);
+
+				address += n * sizeof(word);
+				i += n;
+			}
+		}
+
+	public:
+		/// <summary> The start address of this RAM </summary>
+		word address_start = 0;
+		/// <summary> The size of this RAM in bytes </summary>
+		word address_size = 0;
+		/// <summary> What memory that hasn't been written to reads as </summary>
+		byte default_byte = 0;
+		word default_word = 0;
+		/// <summary> The data written to the start of memory when the device is reset, if any </summary>
+		std::shared_ptr<word[]> default_memory;
+		word default_memory_words = 0;
+
+		/// <summary> Each page of memory, or null until it's written to </summary>
+		std::vector<std::unique_ptr<word[]>> pages;
+		/// <summary> The number of pages that have been allocated </summary>
+		word committed_pages = 0;
+
+		SparseRAM(word address, word size, std::shared_ptr<word[]>& memory, word memory_words, char default_byte = 0);
+		SparseRAM(word address, word size, char default_byte = 0);
+
+		void WriteForced(word address, word value);
+		void WriteByteForced(word address, byte value);
+
+		void Write(word address, word value);
+		void WriteByte(word address, byte value);
+
+		word Read(word address);
+		byte ReadByte(word address);
+
+		void ReadBlock(word address, word* values, word count);
+		void WriteBlock(word address, const word* values, word count);
+		void WriteBlockForced(word address, const word* values, word count);
+		void Fill(word address, word value, word count);
+		void FillForced(word address, word value, word count);
+
+		/// <summary> The number of bytes of memory that have been allocated </summary>
+		inline size_t GetResidentSize() const { return (size_t)committed_pages * page_size; }
+
+		inline word GetAddress() const { return address_start; }
+		inline word GetRange() const { return address_size; }
+
+		constexpr const Device_ID GetID() const { return SPARSE_RAM_DEVICE; }
+
+		/// <summary> Frees every page, so memory reads as the default byte again, and writes the default memory back </summary>
+		void Reset();
+	};
+}
+
+#endif
\ No newline at end of file
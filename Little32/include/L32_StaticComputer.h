@@ -0,0 +1,277 @@
+#pragma once
+
+#ifndef L32_StaticComputer_h_
+#define L32_StaticComputer_h_
+
+#include "L32_Computer.h"
+#include "L32_IDevice.h"
+#include "L32_IMappedDevice.h"
+#include "L32_IMemoryMapped.h"
+#include "L32_L32CoreImpl.h"
+#include "L32_ROM.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Little32
+{
+	/// <summary> A device of a known type, at a known place in memory </summary>
+	/// <typeparam name="Device">The concrete type of the device, e.g. RAM</typeparam>
+	/// <typeparam name="start">The first address the device is mapped to</typeparam>
+	/// <typeparam name="range">The number of bytes the device is mapped to</typeparam>
+	template<typename Device, word start, word range>
+	struct StaticMapping
+	{
+		using DeviceType = Device;
+
+		static constexpr word address = start;
+		static constexpr word size = range;
+
+		static_assert(std::is_base_of_v<IMemoryMapped, Device>, "Mapped devices must be IMemoryMapped");
+
+		static constexpr bool Contains(word addr) { return addr - address < size; }
+	};
+
+	/// <summary> The core a StaticComputer runs: its own build of the core if it has one, e.g. BasicLittle32Core, or else the core as it is </summary>
+	template<typename Core, typename Memory, typename = void>
+	struct StaticCore { using type = Core; };
+
+	// Only cores that are exactly a rebindable core built for Computer, so a derived core like Little32JITCore isn't swapped for its base
+	template<typename Core, typename Memory>
+	struct StaticCore<Core, Memory, std::enable_if_t<std::is_same_v<Core, typename Core::template Rebind<Computer>>>>
+	{
+		using type = typename Core::template Rebind<Memory>;
+	};
+
+	/// <summary>
+	/// A computer whose core and memory layout are fixed at compile time, usually written by WriteStaticComputer from a config.
+	/// Reads and writes are decoded against constant addresses and call each device without virtual dispatch,
+	/// so accesses to RAM and ROM inline straight into their memory.
+	/// The core is built against this type, so its own accesses call Read and Write directly, while everything else reaches them through the bus Bind sets up.
+	/// Devices are still created and added as normal, e.g. by their factories, and then found with Bind.
+	/// </summary>
+	/// <typeparam name="Core">The concrete type of the core</typeparam>
+	/// <typeparam name="Mappings">A StaticMapping for every mapping and mapped device, in the order they were added</typeparam>
+	template<typename Core, typename... Mappings>
+	struct StaticComputer : public Computer
+	{
+		using CoreType = typename StaticCore<Core, StaticComputer>::type;
+
+		CoreType static_core;
+		std::tuple<typename Mappings::DeviceType*...> static_devices = {};
+
+		StaticComputer() : Computer(), static_core(*this)
+		{
+			core = &static_core;
+		}
+
+		/// <summary> Finds the device for every mapping, and routes memory accesses through them </summary>
+		/// <exception cref="std::runtime_error">Thrown when the devices that were added don't match the mappings</exception>
+		void Bind()
+		{
+			bus = nullptr;
+
+			if (mappings.size() + mapped_devices.size() != sizeof...(Mappings))
+			{
+				throw std::runtime_error("Computer has " + std::to_string(mappings.size() + mapped_devices.size()) + " mapped devices, but its layout has " + std::to_string(sizeof...(Mappings)));
+			}
+
+			BindEach(std::index_sequence_for<Mappings...>());
+
+			static constexpr Bus static_bus
+			{
+				[](Computer& computer, word addr) { return static_cast<StaticComputer&>(computer).Read(addr); },
+				[](Computer& computer, word addr) { return static_cast<StaticComputer&>(computer).ReadByte(addr); },
+				[](Computer& computer, word addr, word value) { static_cast<StaticComputer&>(computer).Write(addr, value); },
+				[](Computer& computer, word addr, byte value) { static_cast<StaticComputer&>(computer).WriteByte(addr, value); }
+			};
+
+			bus = &static_bus;
+		}
+
+		/// <summary> Clocks the computer a number of times </summary>
+		/// <param name="clocks">Number of times to clock the computer</param>
+		inline void Clock(unsigned clocks)
+		{
+			const Computer* const outer = clocking;
+			clocking = this;
+
+			while (clocks > 0)
+			{
+				CheckIntervals();
+				interrupts.Deliver();
+
+				// Like Computer, a halted core skips to the next interval
+				if (halted)
+				{
+					halted = false;
+
+					if (constant_intervals.empty() && static_core.CoreType::IsHalted())
+					{
+						clocks -= SkipHalt(clocks);
+						continue;
+					}
+				}
+
+				// And runs uninterrupted until then otherwise
+				const size_t until_deadline = std::max<size_t>(NextDeadline() - cur_cycle, 1);
+				const word budget = until_deadline < clocks ? (word)until_deadline : clocks;
+
+				yield = false;
+				const word ran = static_core.CoreType::Run(budget);
+
+				cur_cycle += ran;
+				clocks -= ran;
+			}
+
+			clocking = outer;
+		}
+
+		/// <summary> Clocks the computer once </summary>
+		inline void Clock()
+		{
+			CheckIntervals();
+			interrupts.Deliver();
+			static_core.CoreType::Clock();
+			cur_cycle++;
+		}
+
+		inline word Read(word addr)
+		{
+			return ReadEach(addr, std::index_sequence_for<Mappings...>());
+		}
+
+		inline byte ReadByte(word addr)
+		{
+			return ReadByteEach(addr, std::index_sequence_for<Mappings...>());
+		}
+
+		inline void Write(word addr, word value)
+		{
+			WriteEach(addr, value, std::index_sequence_for<Mappings...>());
+		}
+
+		inline void WriteByte(word addr, byte value)
+		{
+			WriteByteEach(addr, value, std::index_sequence_for<Mappings...>());
+		}
+
+	private:
+		template<size_t I>
+		using MappingAt = std::tuple_element_t<I, std::tuple<Mappings...>>;
+
+		template<size_t I>
+		void BindOne()
+		{
+			using Mapping = MappingAt<I>;
+			using Device = typename Mapping::DeviceType;
+
+			Device*& device = std::get<I>(static_devices);
+			device = nullptr;
+
+			const auto Matches = [](IMemoryMapped* m) { return m->GetAddress() == Mapping::address && m->GetRange() == Mapping::size; };
+
+			for (IMemoryMapped* m : mappings)
+			{
+				if (Matches(m)) device = dynamic_cast<Device*>(m);
+				if (device != nullptr) return;
+			}
+
+			for (IMappedDevice* m : mapped_devices)
+			{
+				if (Matches(m)) device = dynamic_cast<Device*>(m);
+				if (device != nullptr) return;
+			}
+
+			throw std::runtime_error("No device matches mapping " + std::to_string(I) + " of the computer's layout");
+		}
+
+		template<size_t... I>
+		void BindEach(std::index_sequence<I...>) { (BindOne<I>(), ...); }
+
+		// Like Computer, every device that contains the address responds, and what they read is ORed together
+
+		template<size_t I>
+		inline void ReadOne(word addr, word& value)
+		{
+			using Mapping = MappingAt<I>;
+			using Device = typename Mapping::DeviceType;
+
+			if (Mapping::Contains(addr)) value |= std::get<I>(static_devices)->Device::Read(addr - Mapping::address);
+		}
+
+		template<size_t I>
+		inline void ReadByteOne(word addr, byte& value)
+		{
+			using Mapping = MappingAt<I>;
+			using Device = typename Mapping::DeviceType;
+
+			if (Mapping::Contains(addr)) value |= std::get<I>(static_devices)->Device::ReadByte(addr - Mapping::address);
+		}
+
+		template<size_t I>
+		inline void WriteOne(word addr, word value)
+		{
+			using Mapping = MappingAt<I>;
+			using Device = typename Mapping::DeviceType;
+
+			if (!Mapping::Contains(addr)) return;
+
+			// ROM ignores the write, so nothing the core cached about it goes stale
+			if constexpr (!std::is_same_v<Device, ROM>) static_core.CoreType::InvalidateCache(addr, sizeof(word));
+
+			std::get<I>(static_devices)->Device::Write(addr - Mapping::address, value);
+		}
+
+		template<size_t I>
+		inline void WriteByteOne(word addr, byte value)
+		{
+			using Mapping = MappingAt<I>;
+			using Device = typename Mapping::DeviceType;
+
+			if (!Mapping::Contains(addr)) return;
+
+			if constexpr (!std::is_same_v<Device, ROM>) static_core.CoreType::InvalidateCache(addr, sizeof(byte));
+
+			std::get<I>(static_devices)->Device::WriteByte(addr - Mapping::address, value);
+		}
+
+		template<size_t... I>
+		inline word ReadEach(word addr, std::index_sequence<I...>)
+		{
+			word value = 0;
+			(ReadOne<I>(addr, value), ...);
+			return value;
+		}
+
+		template<size_t... I>
+		inline byte ReadByteEach(word addr, std::index_sequence<I...>)
+		{
+			byte value = 0;
+			(ReadByteOne<I>(addr, value), ...);
+			return value;
+		}
+
+		template<size_t... I>
+		inline void WriteEach(word addr, word value, std::index_sequence<I...>) { (WriteOne<I>(addr, value), ...); }
+
+		template<size_t... I>
+		inline void WriteByteEach(word addr, byte value, std::index_sequence<I...>) { (WriteByteOne<I>(addr, value), ...); }
+	};
+
+	/// <summary>
+	/// Writes a header declaring a StaticComputer with the same layout as a computer, e.g. one set up from a config.
+	/// </summary>
+	/// <param name="computer">The computer, with all of its devices added</param>
+	/// <param name="core_type">The name of the type of core to use, e.g. "Little32Core"</param>
+	/// <param name="type_name">The name to give the StaticComputer type</param>
+	/// <param name="out">Where the header is written to</param>
+	/// <exception cref="std::runtime_error">Thrown when a device doesn't have a known type</exception>
+	void WriteStaticComputer(const Computer& computer, const std::string& core_type, const std::string& type_name, std::ostream& out);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#ifndef L32_TimerDevice_h_
+#define L32_TimerDevice_h_
+
+#include "L32_IDeviceFactory.h"
+#include "L32_IMappedDevice.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Little32
+{
+	struct Computer;
+
+	/// <summary>
+	/// A free-running 64-bit cycle counter, with compare channels that interrupt once the counter reaches them.
+	/// Channels are one-shot, or periodic where the compare value moves on by the period each time it's reached.
+	/// The computer only clocks the timer on the cycle its next armed channel is due, so idle channels cost nothing.
+	/// </summary>
+	struct TimerDevice : public IMappedDevice
+	{
+		static constexpr word max_channels = 8;
+
+		// Word offsets of the timer's registers
+
+		/// <summary> The low word of the counter. Reading it latches the high word, so the two read as one value </summary>
+		static constexpr word COUNTER_LOW = 0;
+		/// <summary> The high word of the counter, as it was when the low word was last read </summary>
+		static constexpr word COUNTER_HIGH = 1;
+		/// <summary> Bit n is set when channel n reaches its compare value. Writing 1 to a bit clears it </summary>
+		static constexpr word STATUS = 2;
+		/// <summary> The number of channels, read only </summary>
+		static constexpr word CHANNEL_COUNT = 3;
+		/// <summary> Where the first channel's registers start. Each channel has channel_words of them </summary>
+		static constexpr word CHANNELS = 4;
+
+		// Word offsets of each channel's registers, from the start of the channel
+
+		/// <summary> Bit 0 enables the channel, and bit 1 makes it periodic. One-shot channels disable themselves once reached </summary>
+		static constexpr word CHANNEL_CONTROL = 0;
+		/// <summary> The low word of the counter the channel is reached at </summary>
+		static constexpr word CHANNEL_COMPARE = 1;
+		/// <summary> How far the compare value moves on each time a periodic channel is reached. 0 stops it like a one-shot </summary>
+		static constexpr word CHANNEL_PERIOD = 2;
+		/// <summary> The interrupt posted when the channel is reached, or 0 for none </summary>
+		static constexpr word CHANNEL_INTERRUPT = 3;
+
+		static constexpr word channel_words = 4;
+
+		static constexpr word CONTROL_ENABLE = 0b01;
+		static constexpr word CONTROL_PERIODIC = 0b10;
+
+		struct Channel
+		{
+			word control = 0;
+			word compare = 0;
+			word period = 0;
+			word interrupt = 0;
+			/// <summary> The computer's cycle the channel is next reached on, while it's enabled </summary>
+			size_t due = 0;
+		};
+
+		/// <summary> The start address of this timer </summary>
+		word address_start = 0;
+		word channel_count = 0;
+
+		/// <summary> The computer's cycle the counter was last at 0 </summary>
+		size_t counter_start = 0;
+		word latched_high = 0;
+		word status = 0;
+
+		std::array<Channel, max_channels> channels = {};
+
+		/// <summary> The source channel interrupts are posted from </summary>
+		word interrupt_source = 0;
+
+		Computer& computer;
+
+		TimerDevice(Computer& computer, word address, word channel_count);
+		~TimerDevice();
+
+		uint64_t Counter() const;
+
+		void Clock();
+		size_t CyclesUntilClock();
+		void Reset();
+
+		void Write(word address, word value);
+		void WriteByte(word address, byte value);
+
+		void WriteForced(word address, word value);
+		void WriteByteForced(word address, byte value);
+
+		word Read(word address);
+		byte ReadByte(word address);
+
+		inline word GetAddress() const { return address_start; }
+		inline word GetRange() const { return (CHANNELS + channel_count * channel_words) * sizeof(word); }
+
+		constexpr const Device_ID GetID() const { return TIMER_DEVICE; }
+
+	private:
+		/// <summary> Works out when a channel is next reached from its compare value, after it's enabled or the counter or compare value change </summary>
+		void Arm(Channel& channel);
+
+		/// <summary> Reads a register by its word offset, without latching the counter </summary>
+		word Peek(word index) const;
+	};
+
+	struct TimerDeviceFactory : IDeviceFactory
+	{
+		void CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path path) const;
+		void VerifySettings(const IDeviceSettings& settings, std::filesystem::path path) const;
+	};
+}
+
+#endif
\ No newline at end of file
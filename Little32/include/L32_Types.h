@@ -19,7 +19,10 @@ namespace Little32
 		RAM_DEVICE = 3,
 		CHARDISPLAY_DEVICE = 4,
 		COLOURCHARDISPLAY_DEVICE = 5,
-		KEYBOARD_DEVICE = 6
+		KEYBOARD_DEVICE = 6,
+		SPARSE_RAM_DEVICE = 7,
+		TIMER_DEVICE = 8,
+		DMA_DEVICE = 9
 	};
 
 	enum ValueType
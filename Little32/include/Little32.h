@@ -20,27 +20,39 @@
 #include "L32_IMemoryMapped.h"
 #include "L32_IMappedDevice.h"
 #include "L32_ICore.h"
+#include "L32_CoroutineDevice.h"
 
 // Helpers
 #include "L32_GUIButton.h"
 #include "L32_IO.h"
 #include "L32_Sprite.h"
 #include "L32_ImageLoader.h"
+#include "L32_MappedFile.h"
+#include "L32_ImageCache.h"
 
 // System
 #include "L32_Computer.h"
 #include "L32_DebugCore.h"
+#include "L32_InterruptController.h"
 #include "L32_L32Assembler.h"
 #include "L32_L32Core.h"
+#include "L32_L32JITCore.h"
+#include "L32_L32AOTCore.h"
+#include "L32_L32Recompiler.h"
+#include "L32_L32BatchCore.h"
+#include "L32_StaticComputer.h"
 
 // Devices
 #include "L32_CharDisplay.h"
 #include "L32_ColourCharDisplay.h"
 #include "L32_ComputerInfo.h"
+#include "L32_DMADevice.h"
 #include "L32_KeyboardDevice.h"
 #include "L32_EmptyDeviceFactory.h"
 #include "L32_NullDevice.h"
 #include "L32_RAM.h"
 #include "L32_ROM.h"
+#include "L32_SparseRAM.h"
+#include "L32_TimerDevice.h"
 
 #endif
\ No newline at end of file
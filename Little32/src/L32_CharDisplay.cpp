@@ -43,6 +43,8 @@ namespace Little32
 		defaultMemory(memory),
 		memory(new byte[address_size](0))
 	{
+		interrupt_source = computer.interrupts.AddSource();
+
 		if (!defaultMemory) return;
 		memcpy(this->memory.get(), defaultMemory.get(), address_size);
 	}
@@ -58,7 +60,15 @@ namespace Little32
 		address_start(address),
 		address_size(textSize.w * textSize.h),
 		interrupt_address(0),
-		memory(new byte[address_size](0)) {}
+		memory(new byte[address_size](0))
+	{
+		interrupt_source = computer.interrupts.AddSource();
+	}
+
+	CharDisplay::~CharDisplay()
+	{
+		computer.interrupts.RemoveSource(interrupt_source);
+	}
 
 	void CharDisplay::Write(word address, word value)
 	{
@@ -137,7 +147,7 @@ namespace Little32
 		}
 		if (interrupt_address != 0 && do_interrupt)
 		{
-			computer.core->Interrupt(interrupt_address);
+			computer.interrupts.Post(interrupt_source, interrupt_address);
 		}
 	}
 
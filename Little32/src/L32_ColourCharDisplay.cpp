@@ -14,6 +14,7 @@ namespace Little32
 {
 	void ColourCharDisplay::_WriteTextWordUnsafe(word address, word value)
 	{
+		text_dirty = true;
 		text_memory[address + 0] = value >> 0;
 		text_memory[address + 1] = value >> 8;
 		text_memory[address + 2] = value >> 16;
@@ -22,11 +23,13 @@ namespace Little32
 
 	void ColourCharDisplay::_WriteTextByteUnsafe(word address, byte value)
 	{
+		text_dirty = true;
 		text_memory[address] = value;
 	}
 
 	void ColourCharDisplay::_WriteColourWordUnsafe(word address, word value)
 	{
+		colour_dirty = true;
 		colour_memory[address + 0] = value >> 0;
 		colour_memory[address + 1] = value >> 8;
 		colour_memory[address + 2] = value >> 16;
@@ -35,6 +38,7 @@ namespace Little32
 
 	void ColourCharDisplay::_WriteColourByteUnsafe(word address, byte value)
 	{
+		colour_dirty = true;
 		colour_memory[address] = value;
 	}
 
@@ -66,6 +70,26 @@ namespace Little32
 		return colour_memory[address];
 	}
 
+	byte* ColourCharDisplay::_FindBlockUnsafe(word address, word count, bool write)
+	{
+		if (address % sizeof(word) != 0 || count > pixel_area / sizeof(word)) return nullptr;
+
+		const word size = count * sizeof(word);
+
+		if (address <= pixel_area - size)
+		{
+			text_dirty |= write;
+			return text_memory.get() + address;
+		}
+		if (address >= colour_position && address - colour_position <= pixel_area - size)
+		{
+			colour_dirty |= write;
+			return colour_memory.get() + (address - colour_position);
+		}
+
+		return nullptr;
+	}
+
 	ColourCharDisplay::ColourCharDisplay(Computer& computer, SDL::Renderer r, SDL::Texture txt, SDL::Point texture_position, SDL::Point texture_char_size, word texture_columns, SDL::Point text_size, SDL::Point pixel_position, SDL::Point pixel_scale, word address, std::shared_ptr<byte[]>& text_memory, std::shared_ptr<byte[]>& colour_memory) :
 		computer(computer),
 		r(r),
@@ -143,6 +167,8 @@ namespace Little32
 
 	ColourCharDisplay::~ColourCharDisplay()
 	{
+		computer.interrupts.RemoveSource(interrupt_source);
+
 		if (refresh_interval == nullptr) return;
 
 		computer.RemoveInterval(refresh_interval);
@@ -339,6 +365,8 @@ namespace Little32
 			}
 		}
 
+		computer.interrupts.SetPriority(ccd->interrupt_source, settings.GetInterruptPriority());
+
 		computer.AddMappedDevice(*ccd);
 		start_address += ccd->GetRange();
 
@@ -523,6 +551,8 @@ namespace Little32
 			framerate_lock = val.bits.empty() ? 0 : static_cast<uint32_t>(val.bits[0]);
 		}
 
+		settings.VerifyInterruptPriority();
+
 		SDL::Renderer r = SDL::Renderer(texture.renderer);
 
 		const ConfigObject* labels_obj;
@@ -637,6 +667,42 @@ namespace Little32
 		}
 	}
 
+	// Words are kept little endian, the same as the host, so whole blocks can be copied at once
+
+	void ColourCharDisplay::ReadBlock(word address, word* values, word count)
+	{
+		const byte* const memory = _FindBlockUnsafe(address, count, false);
+		if (memory == nullptr) return IMappedDevice::ReadBlock(address, values, count);
+
+		memcpy(values, memory, count * sizeof(word));
+	}
+
+	void ColourCharDisplay::WriteBlock(word address, const word* values, word count)
+	{
+		byte* const memory = _FindBlockUnsafe(address, count, true);
+		if (memory == nullptr) return IMappedDevice::WriteBlock(address, values, count);
+
+		memcpy(memory, values, count * sizeof(word));
+	}
+
+	void ColourCharDisplay::WriteBlockForced(word address, const word* values, word count)
+	{
+		WriteBlock(address, values, count);
+	}
+
+	void ColourCharDisplay::Fill(word address, word value, word count)
+	{
+		byte* const memory = _FindBlockUnsafe(address, count, true);
+		if (memory == nullptr) return IMappedDevice::Fill(address, value, count);
+
+		for (word i = 0; i < count; i++) memcpy(memory + i * sizeof(word), &value, sizeof(word));
+	}
+
+	void ColourCharDisplay::FillForced(word address, word value, word count)
+	{
+		Fill(address, value, count);
+	}
+
 	void ColourCharDisplay::Render(bool doInterrupt)
 	{
 		if (address_size == 0) return;
@@ -669,17 +735,26 @@ namespace Little32
 
 		if (interrupt_address != 0 && doInterrupt)
 		{
-			computer.core->Interrupt(interrupt_address);
+			computer.interrupts.Post(interrupt_source, interrupt_address);
 		}
 	}
 
 	void ColourCharDisplay::Reset()
 	{
-		if (default_text_memory) memcpy(text_memory.get(), default_text_memory.get(), pixel_area);
-		else memset(text_memory.get(), 0, pixel_area);
+		// Memory that hasn't been written still holds what it started with
+		if (text_dirty)
+		{
+			if (default_text_memory) memcpy(text_memory.get(), default_text_memory.get(), pixel_area);
+			else memset(text_memory.get(), 0, pixel_area);
+		}
 
-		if (default_colour_memory) memcpy(colour_memory.get(), default_colour_memory.get(), pixel_area);
-		else memset(colour_memory.get(), 0x0F, pixel_area);
+		if (colour_dirty)
+		{
+			if (default_colour_memory) memcpy(colour_memory.get(), default_colour_memory.get(), pixel_area);
+			else memset(colour_memory.get(), 0x0F, pixel_area);
+		}
+
+		text_dirty = colour_dirty = false;
 
 		interrupt_address = 0;
 	};
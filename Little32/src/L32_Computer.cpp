@@ -4,166 +4,513 @@
 #include "L32_IDevice.h"
 #include "L32_IMappedDevice.h"
 #include "L32_IMemoryMapped.h"
+#include "L32_RAM.h"
+#include "L32_ROM.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace Little32
 {
-	void Computer::Clock(unsigned clocks)
+	namespace
 	{
-		for (; clocks > 0; clocks--)
+		/// <summary> Splits a block of words where it crosses into another page, as each page is mapped separately </summary>
+		template<typename F>
+		void ForEachPage(Computer& computer, word addr, word count, F f)
 		{
-			CheckIntervals();
+			for (word i = 0; i < count;)
+			{
+				const word n = std::min<word>(count - i, (Computer::page_size - addr % Computer::page_size) / sizeof(word));
+
+				f(computer.FindPage(addr), addr, i, n);
+
+				addr += n * sizeof(word);
+				i += n;
+			}
+		}
 
-			for (size_t i = 0; i < devices.size(); i++)
+		/// <summary> Returns the only device mapped to part of a page, if it covers all of it, otherwise null </summary>
+		const Computer::PageMapping* FindSoleMapping(const Computer::Page& page, word addr, word count)
+		{
+			const uint64_t end = (uint64_t)addr + count * sizeof(word);
+			const Computer::PageMapping* sole = nullptr;
+
+			for (const Computer::PageMapping& m : page.mappings)
 			{
-				devices[i]->Clock();
+				if (addr >= (uint64_t)m.start + m.range || end <= m.start) continue;
+				if (sole != nullptr || addr < m.start || end > (uint64_t)m.start + m.range) return nullptr;
+
+				sole = &m;
 			}
-			for (size_t i = 0; i < mapped_devices.size(); i++)
+
+			return sole;
+		}
+
+		constexpr word BlockRange(word count)
+		{
+			return count <= ~(word)0 / sizeof(word) ? count * sizeof(word) : ~(word)0;
+		}
+	}
+
+	void Computer::Clock(unsigned clocks)
+	{
+		const Computer* const outer = clocking;
+		clocking = this;
+
+		while (clocks > 0)
+		{
+			CheckIntervals();
+
+			// Between runs is always between instructions
+			interrupts.Deliver();
+
+			// The core may have been interrupted since it ran the HALT, so check it's still there.
+			// Intervals that run every clock could do anything, so only skip when there are none
+			if (halted)
 			{
-				mapped_devices[i]->Clock();
+				halted = false;
+
+				if (constant_intervals.empty() && core->IsHalted())
+				{
+					clocks -= SkipHalt(clocks);
+					continue;
+				}
 			}
-			core->Clock();
-			cur_cycle++;
+
+			// Nothing outside the core happens until the next interval or device clock is due
+			const size_t until_deadline = std::max<size_t>(NextDeadline() - cur_cycle, 1);
+			const word budget = until_deadline < clocks ? (word)until_deadline : clocks;
+
+			yield = false;
+			const word ran = core->Run(budget);
+
+			cur_cycle += ran;
+			clocks -= ran;
 		}
+
+		clocking = outer;
 	}
 
-	void Computer::Clock()
+	size_t Computer::Now() const
 	{
-		CheckIntervals();
+		return core == nullptr ? cur_cycle : cur_cycle + core->CyclesRun();
+	}
 
-		for (size_t i = 0; i < devices.size(); i++)
+	unsigned Computer::SkipHalt(unsigned clocks)
+	{
+		// Nothing but an interrupt gets the core out of HALT, so it can't change until the next interval or device clock fires one
+		const size_t next = NextDeadline();
+		const unsigned skip = next - cur_cycle > clocks ? clocks : (unsigned)(next - cur_cycle);
+
+		cur_cycle += skip;
+		return skip;
+	}
+
+	void Computer::RunIntervals()
+	{
+		// Indexed, as callbacks can add more of them
+		for (size_t c = 0; c < constant_intervals.size();)
 		{
-			devices[i]->Clock();
+			const std::shared_ptr<Interval> i = constant_intervals[c];
+			i->callback(*this);
+
+			if (i->repeats == 1)
+			{
+				constant_intervals.erase(constant_intervals.begin() + c);
+				continue;
+			}
+
+			--(i->repeats);
+			++c;
 		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
+
+		while (!schedule.empty() && schedule.front().cycle <= cur_cycle)
+		{
+			std::pop_heap(schedule.begin(), schedule.end(), ScheduledInterval::Later);
+			const std::shared_ptr<Interval> i = std::move(schedule.back().interval);
+			schedule.pop_back();
+
+			i->callback(*this);
+
+			if (i->repeats == 1) continue;
+
+			--(i->repeats);
+
+			// Goes after everything already due on the same cycle, as it always has
+			Schedule(cur_cycle + i->cycle_length, i);
+		}
+
+		// Devices are clocked after intervals, like they always have been
+		while (!device_schedule.empty() && device_schedule.front().cycle <= cur_cycle)
+		{
+			std::pop_heap(device_schedule.begin(), device_schedule.end(), ScheduledDevice::Later);
+			IDevice* const device = device_schedule.back().device;
+			device_schedule.pop_back();
+
+			device->Clock();
+
+			// Replaces wherever the device rescheduled itself during Clock, if it did
+			ScheduleClock(*device);
+		}
+
+		UpdateDeadline();
+	}
+
+	void Computer::ScheduleClock(IDevice& device)
+	{
+		const size_t old_deadline = next_deadline;
+
+		Unschedule(device);
+
+		const size_t cycles = device.CyclesUntilClock();
+
+		// At least a cycle away, as whatever is due now has already been run
+		if (cycles != IDevice::never)
 		{
-			mapped_devices[i]->Clock();
+			device_schedule.push_back({ Now() + std::max<size_t>(cycles, 1), schedule_order++, &device });
+			std::push_heap(device_schedule.begin(), device_schedule.end(), ScheduledDevice::Later);
 		}
+
+		UpdateDeadline();
+
+		// The core may be part way through a run that was meant to go past it
+		if (next_deadline < old_deadline) yield = true;
+	}
+
+	bool Computer::Unschedule(IDevice& device)
+	{
+		const auto scheduled = std::find_if(device_schedule.begin(), device_schedule.end(), [&](const ScheduledDevice& s) { return s.device == &device; });
+
+		if (scheduled == device_schedule.end()) return false;
+
+		// Anything could have moved into its place, so the heap is rebuilt around the hole
+		*scheduled = device_schedule.back();
+		device_schedule.pop_back();
+		std::make_heap(device_schedule.begin(), device_schedule.end(), ScheduledDevice::Later);
+
+		UpdateDeadline();
+		return true;
+	}
+
+	void Computer::Clock()
+	{
+		CheckIntervals();
+		interrupts.Deliver();
 		core->Clock();
 		cur_cycle++;
 	}
 
-	word Computer::Read(word addr)
+	void Computer::WaitForInterrupt(std::chrono::milliseconds timeout)
 	{
-		word value = 0;
-		for (size_t i = 0; i < mappings.size(); i++)
-		{
-			const word start = mappings[i]->GetAddress();
+		std::unique_lock lock(wait_mutex);
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		// Only interrupts from now on count. One that already happened has moved the core out of its halt
+		interrupted = false;
+
+		// Parked before checking for posts, and NotifyInterrupt checks in the opposite order, so either the post is seen here or it sees the thread parked
+		parked.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// Anything posted before the wait started would never wake it
+		if (core->IsHalted() && !interrupts.HasPosted()) wait_condition.wait_for(lock, timeout, [this] { return interrupted; });
+
+		parked.store(false, std::memory_order_relaxed);
+	}
+
+	void Computer::NotifyInterrupt()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// Almost always nothing is waiting, so posting doesn't have to take the mutex
+		if (!parked.load(std::memory_order_relaxed)) return;
 
-			value |= mappings[i]->Read(addr - start);
-		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
 		{
-			const word start = mapped_devices[i]->GetAddress();
+			std::lock_guard lock(wait_mutex);
+			interrupted = true;
+		}
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+		wait_condition.notify_all();
+	}
+
+	word Computer::Read(word addr)
+	{
+		if (bus != nullptr) return bus->read(*this, addr);
 
-			value |= mapped_devices[i]->Read(addr - start);
+		const Page* const page = FindPage(addr);
+		if (page == nullptr) return 0;
+
+		// Unaligned reads are left to the device, as memory reads a byte for them
+		if (page->read_memory != nullptr && addr % sizeof(word) == 0) return page->read_memory[(addr % page_size) / sizeof(word)];
+
+		word value = 0;
+		for (const PageMapping& m : page->mappings)
+		{
+			if (addr < m.start || addr >= m.start + m.range) continue;
+
+			value |= m.device->Read(addr - m.start);
 		}
 		return value;
 	}
 
 	byte Computer::ReadByte(word addr)
 	{
-		byte value = 0;
-		for (size_t i = 0; i < mappings.size(); i++)
-		{
-			const word start = mappings[i]->GetAddress();
+		if (bus != nullptr) return bus->read_byte(*this, addr);
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		const Page* const page = FindPage(addr);
+		if (page == nullptr) return 0;
 
-			value |= mappings[i]->ReadByte(addr - start);
-		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
-		{
-			const word start = mapped_devices[i]->GetAddress();
+		if (page->read_memory != nullptr) return page->read_memory[(addr % page_size) / sizeof(word)] >> ((addr % sizeof(word)) * 8);
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+		byte value = 0;
+		for (const PageMapping& m : page->mappings)
+		{
+			if (addr < m.start || addr >= m.start + m.range) continue;
 
-			value |= mapped_devices[i]->ReadByte(addr - start);
+			value |= m.device->ReadByte(addr - m.start);
 		}
 		return value;
 	}
 
 	void Computer::Write(word addr, word value)
 	{
-		for (size_t i = 0; i < mappings.size(); i++)
-		{
-			const word start = mappings[i]->GetAddress();
+		if (bus != nullptr) return bus->write(*this, addr, value);
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		Page* const page = FindPage(addr);
 
-			mappings[i]->Write(addr - start, value);
-		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
+		// ROM ignores the write, so nothing the core cached about it goes stale
+		if (page == nullptr || page->read_only) return;
+
+		if (core != nullptr) core->InvalidateCache(addr, sizeof(word));
+
+		if (page->write_memory != nullptr && addr % sizeof(word) == 0)
 		{
-			const word start = mapped_devices[i]->GetAddress();
+			page->write_memory[(addr % page_size) / sizeof(word)] = value;
+			return;
+		}
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+		for (const PageMapping& m : page->mappings)
+		{
+			if (addr < m.start || addr >= m.start + m.range) continue;
 
-			mapped_devices[i]->Write(addr - start, value);
+			m.device->Write(addr - m.start, value);
 		}
+
+		EnableWrites(*page);
 	}
 
 	void Computer::WriteByte(word addr, byte value)
 	{
-		for (size_t i = 0; i < mappings.size(); i++)
-		{
-			const word start = mappings[i]->GetAddress();
+		if (bus != nullptr) return bus->write_byte(*this, addr, value);
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		Page* const page = FindPage(addr);
 
-			mappings[i]->WriteByte(addr - start, value);
-		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
+		// ROM ignores the write, so nothing the core cached about it goes stale
+		if (page == nullptr || page->read_only) return;
+
+		if (core != nullptr) core->InvalidateCache(addr, sizeof(byte));
+
+		if (page->write_memory != nullptr)
 		{
-			const word start = mapped_devices[i]->GetAddress();
+			word& w = page->write_memory[(addr % page_size) / sizeof(word)];
+			const word x = (addr % sizeof(word)) * 8;
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+			w = (w & ~((word)0xFF << x)) | ((word)value << x);
+			return;
+		}
+
+		for (const PageMapping& m : page->mappings)
+		{
+			if (addr < m.start || addr >= m.start + m.range) continue;
 
-			mapped_devices[i]->WriteByte(addr - start, value);
+			m.device->WriteByte(addr - m.start, value);
 		}
+
+		EnableWrites(*page);
 	}
 
 	void Computer::WriteForced(word addr, word value)
 	{
-		for (size_t i = 0; i < mappings.size(); i++)
+		if (core != nullptr) core->InvalidateCache(addr, sizeof(word));
+
+		Page* const page = FindPage(addr);
+		if (page == nullptr) return;
+
+		for (const PageMapping& m : page->mappings)
 		{
-			const word start = mappings[i]->GetAddress();
+			if (addr < m.start || addr >= m.start + m.range) continue;
+
+			m.device->WriteForced(addr - m.start, value);
+		}
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		EnableWrites(*page);
+	}
+
+	void Computer::WriteByteForced(word addr, byte value)
+	{
+		if (core != nullptr) core->InvalidateCache(addr, sizeof(byte));
+
+		Page* const page = FindPage(addr);
+		if (page == nullptr) return;
+
+		for (const PageMapping& m : page->mappings)
+		{
+			if (addr < m.start || addr >= m.start + m.range) continue;
 
-			mappings[i]->WriteForced(addr - start, value);
+			m.device->WriteByteForced(addr - m.start, value);
 		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
+
+		EnableWrites(*page);
+	}
+
+	void Computer::ReadBlock(word addr, word* values, word count)
+	{
+		// Through the bus, or unaligned, there's no faster way than a word at a time
+		if (bus != nullptr || addr % sizeof(word) != 0)
 		{
-			const word start = mapped_devices[i]->GetAddress();
+			for (word i = 0; i < count; i++) values[i] = Read(addr + i * sizeof(word));
+			return;
+		}
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+		ForEachPage(*this, addr, count, [&](const Page* page, word addr, word i, word n)
+		{
+			if (page == nullptr)
+			{
+				std::fill_n(values + i, n, 0);
+			}
+			else if (page->read_memory != nullptr)
+			{
+				memcpy(values + i, page->read_memory + (addr % page_size) / sizeof(word), n * sizeof(word));
+			}
+			else if (const PageMapping* m = FindSoleMapping(*page, addr, n))
+			{
+				m->device->ReadBlock(addr - m->start, values + i, n);
+			}
+			else
+			{
+				for (word j = 0; j < n; j++) values[i + j] = Read(addr + j * sizeof(word));
+			}
+		});
+	}
 
-			mapped_devices[i]->WriteForced(addr - start, value);
+	void Computer::WriteBlock(word addr, const word* values, word count)
+	{
+		if (bus != nullptr || addr % sizeof(word) != 0)
+		{
+			for (word i = 0; i < count; i++) Write(addr + i * sizeof(word), values[i]);
+			return;
 		}
+
+		ForEachPage(*this, addr, count, [&](Page* page, word addr, word i, word n)
+		{
+			if (page == nullptr || page->read_only) return;
+
+			if (core != nullptr) core->InvalidateCache(addr, n * sizeof(word));
+
+			if (page->write_memory != nullptr)
+			{
+				memcpy(page->write_memory + (addr % page_size) / sizeof(word), values + i, n * sizeof(word));
+			}
+			else if (const PageMapping* m = FindSoleMapping(*page, addr, n))
+			{
+				m->device->WriteBlock(addr - m->start, values + i, n);
+				EnableWrites(*page);
+			}
+			else
+			{
+				for (word j = 0; j < n; j++) Write(addr + j * sizeof(word), values[i + j]);
+			}
+		});
 	}
 
-	void Computer::WriteByteForced(word addr, byte value)
+	void Computer::WriteBlockForced(word addr, const word* values, word count)
 	{
-		for (size_t i = 0; i < mappings.size(); i++)
+		if (addr % sizeof(word) != 0)
 		{
-			const word start = mappings[i]->GetAddress();
+			for (word i = 0; i < count; i++) WriteForced(addr + i * sizeof(word), values[i]);
+			return;
+		}
 
-			if (addr < start || addr >= start + mappings[i]->GetRange()) continue;
+		if (core != nullptr) core->InvalidateCache(addr, BlockRange(count));
 
-			mappings[i]->WriteByteForced(addr - start, value);
+		ForEachPage(*this, addr, count, [&](Page* page, word addr, word i, word n)
+		{
+			if (page == nullptr) return;
+
+			// Forcing a write into RAM is no different to writing it
+			if (page->write_memory != nullptr)
+			{
+				memcpy(page->write_memory + (addr % page_size) / sizeof(word), values + i, n * sizeof(word));
+			}
+			else if (const PageMapping* m = FindSoleMapping(*page, addr, n))
+			{
+				m->device->WriteBlockForced(addr - m->start, values + i, n);
+				EnableWrites(*page);
+			}
+			else
+			{
+				for (word j = 0; j < n; j++) WriteForced(addr + j * sizeof(word), values[i + j]);
+			}
+		});
+	}
+
+	void Computer::Fill(word addr, word value, word count)
+	{
+		if (bus != nullptr || addr % sizeof(word) != 0)
+		{
+			for (word i = 0; i < count; i++) Write(addr + i * sizeof(word), value);
+			return;
 		}
-		for (size_t i = 0; i < mapped_devices.size(); i++)
+
+		ForEachPage(*this, addr, count, [&](Page* page, word addr, word, word n)
 		{
-			const word start = mapped_devices[i]->GetAddress();
+			if (page == nullptr || page->read_only) return;
 
-			if (addr < start || addr >= start + mapped_devices[i]->GetRange()) continue;
+			if (core != nullptr) core->InvalidateCache(addr, n * sizeof(word));
 
-			mapped_devices[i]->WriteByteForced(addr - start, value);
+			if (page->write_memory != nullptr)
+			{
+				std::fill_n(page->write_memory + (addr % page_size) / sizeof(word), n, value);
+			}
+			else if (const PageMapping* m = FindSoleMapping(*page, addr, n))
+			{
+				m->device->Fill(addr - m->start, value, n);
+				EnableWrites(*page);
+			}
+			else
+			{
+				for (word j = 0; j < n; j++) Write(addr + j * sizeof(word), value);
+			}
+		});
+	}
+
+	void Computer::FillForced(word addr, word value, word count)
+	{
+		if (addr % sizeof(word) != 0)
+		{
+			for (word i = 0; i < count; i++) WriteForced(addr + i * sizeof(word), value);
+			return;
 		}
+
+		if (core != nullptr) core->InvalidateCache(addr, BlockRange(count));
+
+		ForEachPage(*this, addr, count, [&](Page* page, word addr, word, word n)
+		{
+			if (page == nullptr) return;
+
+			if (page->write_memory != nullptr)
+			{
+				std::fill_n(page->write_memory + (addr % page_size) / sizeof(word), n, value);
+			}
+			else if (const PageMapping* m = FindSoleMapping(*page, addr, n))
+			{
+				m->device->FillForced(addr - m->start, value, n);
+				EnableWrites(*page);
+			}
+			else
+			{
+				for (word j = 0; j < n; j++) WriteForced(addr + j * sizeof(word), value);
+			}
+		});
 	}
 
 	void Computer::SoftReset()
@@ -174,6 +521,10 @@ namespace Little32
 
 	void Computer::HardReset()
 	{
+		// RAM forgets which pages were written, so the first write to each has to reach it again
+		for (Page* page : writable_pages) page->write_memory = nullptr;
+		writable_pages.clear();
+
 		for (size_t i = 0; i < devices.size(); i++)
 		{
 			devices[i]->Reset();
@@ -182,22 +533,128 @@ namespace Little32
 		{
 			mapped_devices[i]->Reset();
 		}
+
+		// Devices start counting again from when they were reset
+		device_schedule.clear();
+		for (IDevice* dev : devices) ScheduleClock(*dev);
+		for (IMappedDevice* dev : mapped_devices) ScheduleClock(*dev);
+
+		interrupts.Reset();
+
 		core->Reset();
 		SoftReset();
 	}
 
+	void Computer::ShareImages()
+	{
+		for (IMemoryMapped* m : mappings)
+		{
+			if (m->GetID() == ROM_DEVICE) static_cast<ROM*>(m)->Share();
+		}
+
+		// Pages point straight into the memory that was just replaced
+		BuildPageTable();
+
+		// Only the memory behind the ROM changed, not the devices, so a bus bound to them still holds
+		if (core != nullptr) core->FlushCache();
+	}
+
 	void Computer::AddDevice(IDevice& dev)
 	{
 		devices.push_back(&dev);
+		ScheduleClock(dev);
 	}
 
 	void Computer::AddMapping(IMemoryMapped& map)
 	{
 		mappings.push_back(&map);
+		BuildPageTable();
+
+		// Whatever was cached about the old memory layout is no longer trustworthy
+		if (core != nullptr) core->FlushCache();
+		bus = nullptr;
 	}
 
 	void Computer::AddMappedDevice(IMappedDevice& dev)
 	{
 		mapped_devices.push_back(&dev);
+		ScheduleClock(dev);
+		BuildPageTable();
+
+		if (core != nullptr) core->FlushCache();
+		bus = nullptr;
+	}
+
+	void Computer::BuildPageTable()
+	{
+		for (std::unique_ptr<PageGroup>& group : page_groups) group.reset();
+		writable_pages.clear();
+
+		const auto Map = [&](IMemoryMapped* m)
+		{
+			const uint64_t start = m->GetAddress();
+			const uint64_t end = start + m->GetRange();
+
+			// The bus has never reached devices whose end doesn't fit in 32 bits
+			if (end == start || end > 0xFFFFFFFF) return;
+
+			for (uint64_t i = start >> page_bits; i <= (end - 1) >> page_bits; i++)
+			{
+				std::unique_ptr<PageGroup>& group = page_groups[i >> page_group_bits];
+				if (group == nullptr) group = std::make_unique<PageGroup>();
+
+				(*group)[i & (page_group_size - 1)].mappings.push_back({ m, (word)start, (word)(end - start) });
+			}
+		};
+
+		// In the same order they have always been searched
+		for (IMemoryMapped* m : mappings) Map(m);
+		for (IMappedDevice* m : mapped_devices) Map(m);
+
+		// Pages that are all plain memory from one RAM or ROM are accessed directly.
+		// Anything shared by several devices goes through all of them, so what they read is still ORed together
+		for (word g = 0; g < page_group_count; g++)
+		{
+			if (page_groups[g] == nullptr) continue;
+
+			for (word i = 0; i < page_group_size; i++)
+			{
+				Page& page = (*page_groups[g])[i];
+
+				page.read_only = !page.mappings.empty() && std::all_of(page.mappings.begin(), page.mappings.end(), [](const PageMapping& m) { return m.device->GetID() == ROM_DEVICE; });
+
+				if (page.mappings.size() != 1) continue;
+
+				const PageMapping& m = page.mappings.front();
+				const uint64_t page_start = (uint64_t)((g << page_group_bits) | i) << page_bits;
+
+				if (m.start % sizeof(word) != 0 || page_start < m.start || page_start + page_size > (uint64_t)m.start + m.range) continue;
+
+				const word offset = (word)(page_start - m.start) / sizeof(word);
+
+				switch (m.device->GetID())
+				{
+					case RAM_DEVICE:
+					{
+						RAM& ram = *static_cast<RAM*>(m.device);
+						page.read_memory = ram.memory.get() + offset;
+
+						// Writes are only direct once the RAM has marked the page, which needs its pages to line up with these
+						static_assert(RAM::dirty_page_size == page_size, "RAM pages must match the computer's pages");
+						if (m.start % page_size != 0) break;
+
+						page.ram_memory = page.read_memory;
+						page.ram_dirty = &ram.dirty_pages[(offset * sizeof(word)) >> RAM::dirty_page_bits];
+						EnableWrites(page);
+						break;
+					}
+					case ROM_DEVICE:
+						page.read_memory = static_cast<ROM*>(m.device)->memory.get() + offset;
+						break;
+					default:
+						break;
+				}
+			}
+		}
 	}
 }
\ No newline at end of file
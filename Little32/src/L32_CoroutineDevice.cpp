@@ -0,0 +1,126 @@
+#include "L32_CoroutineDevice.h"
+
+#include "L32_Computer.h"
+
+#include <algorithm>
+
+namespace Little32
+{
+	CoroutineDevice::CoroutineDevice(Computer& computer, word address, word register_count) :
+		address_start(address),
+		registers(register_count, 0),
+		computer(computer) {}
+
+	void CoroutineDevice::SleepFor(size_t cycles)
+	{
+		sleeping = true;
+		wake_cycle = computer.Now() + cycles;
+	}
+
+	void CoroutineDevice::WaitForWrite(word address)
+	{
+		waiting_for_write = true;
+		awaited_address = address;
+	}
+
+	void CoroutineDevice::Resume()
+	{
+		if (!task.Done()) task.Resume();
+	}
+
+	void CoroutineDevice::Clock()
+	{
+		if (!task)
+		{
+			task = Main();
+			task.Promise().device = this;
+			task.Resume();
+			return;
+		}
+
+		// Clocked early, e.g. because the device was just rescheduled
+		if (!sleeping || computer.Now() < wake_cycle) return;
+
+		sleeping = false;
+		timed_out = waiting_for_write;
+		waiting_for_write = false;
+
+		Resume();
+	}
+
+	size_t CoroutineDevice::CyclesUntilClock()
+	{
+		// Started as soon as possible
+		if (!task) return 0;
+
+		if (task.Done() || !sleeping) return never;
+
+		const size_t now = computer.Now();
+		return wake_cycle > now ? wake_cycle - now : 0;
+	}
+
+	void CoroutineDevice::Reset()
+	{
+		// Throws the coroutine away mid-sleep, to start it again on the next clock
+		task = Task();
+
+		sleeping = false;
+		waiting_for_write = false;
+		timed_out = false;
+
+		std::fill(registers.begin(), registers.end(), 0);
+	}
+
+	void CoroutineDevice::Write(word address, word value)
+	{
+		if (address % sizeof(word) != 0 || address >= GetRange()) return;
+
+		registers[address / sizeof(word)] = value;
+
+		if (!waiting_for_write || address != awaited_address) return;
+
+		waiting_for_write = false;
+		sleeping = false;
+		timed_out = false;
+		written_value = value;
+
+		Resume();
+
+		// Woken outside of being clocked, so whatever it's sleeping on now needs scheduling
+		computer.ScheduleClock(*this);
+	}
+
+	void CoroutineDevice::WriteByte(word address, byte value)
+	{
+		const word aligned = address - address % sizeof(word);
+		if (aligned >= GetRange()) return;
+
+		const word x = (address % sizeof(word)) * 8;
+
+		// The whole register is written, so the coroutine sees it the same as a word write
+		Write(aligned, (registers[aligned / sizeof(word)] & ~((word)0xFF << x)) | ((word)value << x));
+	}
+
+	void CoroutineDevice::WriteForced(word address, word value)
+	{
+		Write(address, value);
+	}
+
+	void CoroutineDevice::WriteByteForced(word address, byte value)
+	{
+		WriteByte(address, value);
+	}
+
+	word CoroutineDevice::Read(word address)
+	{
+		if (address % sizeof(word) != 0 || address >= GetRange()) return 0;
+
+		return registers[address / sizeof(word)];
+	}
+
+	byte CoroutineDevice::ReadByte(word address)
+	{
+		const word x = (address % sizeof(word)) * 8;
+		return Read(address - address % sizeof(word)) >> x;
+	}
+}
\ No newline at end of file
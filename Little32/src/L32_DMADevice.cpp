@@ -0,0 +1,180 @@
+#include "L32_DMADevice.h"
+
+#include "L32_Computer.h"
+#include "L32_IDeviceSettings.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Little32
+{
+	DMADevice::DMADevice(Computer& computer, word address)
+		: address_start(address), computer(computer)
+	{
+		interrupt_source = computer.interrupts.AddSource();
+	}
+
+	DMADevice::~DMADevice()
+	{
+		computer.interrupts.RemoveSource(interrupt_source);
+	}
+
+	void DMADeviceFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path path) const
+	{
+		DMADevice* device = new DMADevice(computer, start_address);
+
+		computer.interrupts.SetPriority(device->interrupt_source, settings.GetInterruptPriority());
+
+		start_address += device->GetRange();
+		computer.AddMappedDevice(*device);
+	}
+
+	void DMADeviceFactory::VerifySettings(const IDeviceSettings& settings, std::filesystem::path path) const
+	{
+		settings.VerifyInterruptPriority();
+
+		if (!settings.named_labels.empty())
+		{
+			throw std::runtime_error("Unknown named label: '" + settings.named_labels.begin()->first + "'");
+		}
+	}
+
+	void DMADevice::Copy()
+	{
+		// Copying down from the end, so a destination above an overlapping source isn't read back after it's written
+		if (destination > source)
+		{
+			for (word left = length; left != 0;)
+			{
+				const word n = std::min(left, chunk_words);
+				left -= n;
+
+				computer.ReadBlock(source + left * sizeof(word), buffer.data(), n);
+				computer.WriteBlock(destination + left * sizeof(word), buffer.data(), n);
+			}
+
+			return;
+		}
+
+		for (word done = 0; done != length;)
+		{
+			const word n = std::min(length - done, chunk_words);
+
+			computer.ReadBlock(source + done * sizeof(word), buffer.data(), n);
+			computer.WriteBlock(destination + done * sizeof(word), buffer.data(), n);
+
+			done += n;
+		}
+	}
+
+	void DMADevice::Transfer()
+	{
+		const bool fill = (mode & MODE_FILL) != 0;
+		const bool hold_source = fill || (mode & MODE_HOLD_SOURCE) != 0;
+		const bool hold_destination = (mode & MODE_HOLD_DESTINATION) != 0;
+
+		if (stride == sizeof(word) && !hold_destination && (fill || !hold_source))
+		{
+			if (fill) computer.Fill(destination, source, length);
+			else Copy();
+		}
+		else
+		{
+			// Goes through the bus a word at a time, in order, the same as the guest doing it itself
+			word from = source;
+			word to = destination;
+
+			for (word i = 0; i < length; i++)
+			{
+				computer.Write(to, fill ? source : computer.Read(from));
+
+				if (!hold_source) from += stride;
+				if (!hold_destination) to += stride;
+			}
+		}
+
+		++transfers;
+
+		if (interrupt != 0) computer.interrupts.Post(interrupt_source, interrupt);
+	}
+
+	void DMADevice::Reset()
+	{
+		source = 0;
+		destination = 0;
+		length = 0;
+		stride = sizeof(word);
+		mode = 0;
+		interrupt = 0;
+		transfers = 0;
+	}
+
+	void DMADevice::Write(word address, word value)
+	{
+		if (address % sizeof(word) != 0) return;
+
+		switch (address / sizeof(word))
+		{
+		case SOURCE: source = value; break;
+		case DESTINATION: destination = value; break;
+		case LENGTH: length = value; break;
+		case STRIDE: stride = value; break;
+		case MODE: mode = value & (MODE_FILL | MODE_HOLD_SOURCE | MODE_HOLD_DESTINATION); break;
+		case INTERRUPT: interrupt = value; break;
+		case START: if (value != 0) Transfer(); break;
+		}
+	}
+
+	void DMADevice::WriteByte(word address, byte value)
+	{
+		if (address >= GetRange()) return;
+
+		const word aligned = address & ~3;
+		const word x = (address % sizeof(word)) * 8;
+
+		// Any byte written to START starts a transfer, as a word would
+		if (aligned / sizeof(word) == START)
+		{
+			Write(aligned, value);
+			return;
+		}
+
+		Write(aligned, (Read(aligned) & ~((word)0xFF << x)) | ((word)value << x));
+	}
+
+	void DMADevice::WriteForced(word address, word value)
+	{
+		Write(address, value);
+	}
+
+	void DMADevice::WriteByteForced(word address, byte value)
+	{
+		WriteByte(address, value);
+	}
+
+	word DMADevice::Read(word address)
+	{
+		if (address % sizeof(word) != 0) return 0;
+
+		switch (address / sizeof(word))
+		{
+		case SOURCE: return source;
+		case DESTINATION: return destination;
+		case LENGTH: return length;
+		case STRIDE: return stride;
+		case MODE: return mode;
+		case INTERRUPT: return interrupt;
+		case START: return transfers;
+		default: return 0;
+		}
+	}
+
+	byte DMADevice::ReadByte(word address)
+	{
+		if (address >= GetRange()) return 0;
+
+		const word x = (address % sizeof(word)) * 8;
+
+		return Read(address & ~3) >> x;
+	}
+}
\ No newline at end of file
@@ -62,4 +62,5 @@ namespace Little32
 
 	void DebugCore::SetPC(word value) { PC = value; }
 	void DebugCore::SetSP(word value) { SP = value; }
+	word DebugCore::GetSP() const { return SP; }
 }
\ No newline at end of file
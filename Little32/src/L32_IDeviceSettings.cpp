@@ -5,6 +5,7 @@
 #include "L32_String.h"
 #include "L32_VarValue.h"
 
+#include <cassert>
 #include <exception>
 
 namespace Little32
@@ -129,6 +130,22 @@ namespace Little32
 		settings = settings_value.GetObjectValue().settings;
 	}
 
+	word IDeviceSettings::GetInterruptPriority() const
+	{
+		if (!Contains("interrupt_priority")) return 0;
+
+		assert(settings.at("interrupt_priority").GetType() == INTEGER_VAR);
+		const BigInt& priority = settings.at("interrupt_priority").GetIntegerValue();
+		assert(!priority.negative && priority.NumBits() <= 32);
+
+		return priority.bits.empty() ? 0 : priority.bits[0];
+	}
+
+	void IDeviceSettings::VerifyInterruptPriority() const
+	{
+		if (Contains("interrupt_priority")) MatchUIntRange<0x00000000, 0xFFFFFFFF>(settings.at("interrupt_priority"), "interrupt_priority");
+	}
+
 	bool IDeviceSettings::operator==(const IDeviceSettings & other) const
 	{
 		if (!(component_type == other.component_type
@@ -0,0 +1,197 @@
+#include "L32_ImageCache.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+// We don't want to inherit the min and max macros from windows
+#ifndef NOMINMAX
+#define NOMINMAX
+#include <Windows.h>
+#undef NOMINMAX
+#else
+#include <Windows.h>
+#endif // !NOMINMAX
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Little32
+{
+	namespace
+	{
+		/// <summary> Memory the OS can map more than once, so each view shares the pages that haven't been written to </summary>
+		class Image
+		{
+		public:
+			const size_t size;
+
+			Image(const word* data, size_t size) : size(size)
+			{
+#ifdef _WIN32
+				section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+				if (section == nullptr) throw std::runtime_error("Could not allocate a " + std::to_string(size) + " byte image");
+
+				void* view = MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, size);
+				if (view == nullptr)
+				{
+					CloseHandle(section);
+					throw std::runtime_error("Could not map a " + std::to_string(size) + " byte image");
+				}
+#else
+				static std::atomic<unsigned> image_count = 0;
+
+				// Only named for as long as it takes to open it
+				const std::string name = "/little32-" + std::to_string(getpid()) + "-" + std::to_string(image_count++);
+
+				fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+				if (fd < 0) throw std::runtime_error("Could not allocate a " + std::to_string(size) + " byte image");
+				shm_unlink(name.c_str());
+
+				void* view = ftruncate(fd, (off_t)size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+				if (view == MAP_FAILED)
+				{
+					close(fd);
+					throw std::runtime_error("Could not map a " + std::to_string(size) + " byte image");
+				}
+#endif
+
+				memcpy(view, data, size);
+				contents = static_cast<word*>(view);
+			}
+
+			~Image()
+			{
+#ifdef _WIN32
+				UnmapViewOfFile(contents);
+				CloseHandle(section);
+#else
+				munmap(contents, size);
+				close(fd);
+#endif
+			}
+
+			Image(const Image&) = delete;
+			Image& operator=(const Image&) = delete;
+
+			inline bool Matches(const word* data, size_t size) const
+			{
+				return this->size == size && memcmp(contents, data, size) == 0;
+			}
+
+			/// <summary> Maps another view of the image, whose writes stay private to it </summary>
+			word* MapCopy() const
+			{
+#ifdef _WIN32
+				void* view = MapViewOfFile(section, FILE_MAP_COPY, 0, 0, size);
+				if (view == nullptr) throw std::runtime_error("Could not map a " + std::to_string(size) + " byte image");
+#else
+				void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+				if (view == MAP_FAILED) throw std::runtime_error("Could not map a " + std::to_string(size) + " byte image");
+#endif
+				return static_cast<word*>(view);
+			}
+
+			void Unmap(word* view) const
+			{
+#ifdef _WIN32
+				UnmapViewOfFile(view);
+#else
+				munmap(view, size);
+#endif
+			}
+
+		private:
+			/// <summary> The original contents. Only ever read after the image is created </summary>
+			word* contents = nullptr;
+
+#ifdef _WIN32
+			HANDLE section = nullptr;
+#else
+			int fd = -1;
+#endif
+		};
+
+		/// <summary> FNV-1a, a word at a time </summary>
+		uint64_t Hash(const word* data, word words)
+		{
+			uint64_t hash = 0xCBF29CE484222325ull;
+
+			for (word i = 0; i < words; i++)
+			{
+				hash ^= data[i];
+				hash *= 0x00000100000001B3ull;
+			}
+
+			return hash ^ words;
+		}
+
+		std::mutex images_mutex;
+
+		// Only weakly held, so that an image goes away with the last device using it
+		std::unordered_multimap<uint64_t, std::weak_ptr<const Image>> images;
+	}
+
+	std::shared_ptr<word[]> ImageCache::Map(const word* data, word words)
+	{
+		const uint64_t hash = Hash(data, words);
+		const size_t size = (size_t)words * sizeof(word);
+
+		std::shared_ptr<const Image> image;
+
+		{
+			std::lock_guard<std::mutex> lock(images_mutex);
+
+			const auto [first, last] = images.equal_range(hash);
+
+			for (auto it = first; it != last;)
+			{
+				std::shared_ptr<const Image> candidate = it->second.lock();
+
+				if (!candidate)
+				{
+					it = images.erase(it);
+					continue;
+				}
+
+				// Two images can hash the same, so the contents still have to be compared
+				if (candidate->Matches(data, size))
+				{
+					image = std::move(candidate);
+					break;
+				}
+
+				++it;
+			}
+
+			if (!image)
+			{
+				image = std::make_shared<const Image>(data, size);
+				images.emplace(hash, image);
+			}
+		}
+
+		// Each view keeps the image alive until it's unmapped
+		return std::shared_ptr<word[]>(image->MapCopy(), [image](word* view) { image->Unmap(view); });
+	}
+
+	size_t ImageCache::Count()
+	{
+		std::lock_guard<std::mutex> lock(images_mutex);
+
+		size_t count = 0;
+
+		for (const auto& [hash, image] : images)
+		{
+			if (!image.expired()) count++;
+		}
+
+		return count;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "L32_InterruptController.h"
+
+#include "L32_Computer.h"
+#include "L32_ICore.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace Little32
+{
+	InterruptController::InterruptController(Computer& computer) : computer(computer)
+	{
+		static_assert((queue_size & (queue_size - 1)) == 0, "The queue size must be a power of 2");
+
+		// Each slot is free for the post that would land in it first
+		for (size_t i = 0; i < queue_size; i++) queue[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	word InterruptController::AddSource(word priority)
+	{
+		if (used == ~(word)0) throw std::runtime_error("Can't have more than " + std::to_string(max_sources) + " interrupt sources");
+
+		word source = 0;
+		while ((used >> source) & 1) source++;
+
+		used |= (word)1 << source;
+		priorities[source] = priority;
+		return source;
+	}
+
+	void InterruptController::RemoveSource(word source)
+	{
+		// Anything still in the queue could be from it too
+		Receive();
+
+		std::erase_if(pending, [&](const Pending& p) { return p.source == source; });
+
+		used &= ~((word)1 << source);
+		priorities[source] = 0;
+		Unmask(source);
+	}
+
+	bool InterruptController::Post(word source, word address)
+	{
+		size_t pos = tail.load(std::memory_order_relaxed);
+		Slot* slot;
+
+		while (true)
+		{
+			slot = &queue[pos & (queue_size - 1)];
+			const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+			if (sequence == pos)
+			{
+				// Claims the slot, unless another thread got to it first
+				if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (sequence < pos)
+			{
+				// Still holds something from a lap ago, which hasn't been received
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->source = source;
+		slot->address = address;
+		slot->sequence.store(pos + 1, std::memory_order_release);
+
+		// Posted by something the core called into during its run, e.g. a device it wrote to, so the run stops for it to be delivered
+		if (Computer::clocking == &computer) computer.yield = true;
+
+		// Gets a core parked in WFI going again, so it's there to take the interrupt
+		computer.NotifyInterrupt();
+		return true;
+	}
+
+	void InterruptController::Receive()
+	{
+		while (HasPosted())
+		{
+			Slot& slot = queue[head & (queue_size - 1)];
+
+			pending.push_back({ slot.source, slot.address });
+
+			// Frees the slot for the post a lap from now
+			slot.sequence.store(head + queue_size, std::memory_order_release);
+			head++;
+		}
+	}
+
+	void InterruptController::DeliverPending()
+	{
+		Receive();
+
+		while (!pending.empty())
+		{
+			// The oldest of the highest priority, so sources of the same priority are served in the order they posted
+			auto best = pending.end();
+
+			for (auto it = pending.begin(); it != pending.end(); ++it)
+			{
+				if (IsMasked(it->source)) continue;
+				if (best == pending.end() || priorities[it->source] > priorities[best->source]) best = it;
+			}
+
+			if (best == pending.end()) return;
+
+			const word priority = priorities[best->source];
+
+			// Waits for the running handler, unless it's of a lower priority
+			if (!in_service.empty() && priority <= in_service.back().priority) return;
+
+			const word address = best->address;
+			pending.erase(best);
+
+			computer.core->Interrupt(address);
+			in_service.push_back({ priority, computer.core->GetSP() });
+		}
+	}
+
+	void InterruptController::Return(word SP)
+	{
+		// Only handlers this delivered are tracked. Anything else that interrupted the core returns with a different stack
+		if (in_service.empty() || in_service.back().SP != SP) return;
+
+		in_service.pop_back();
+
+		// Whatever was held back can go as soon as the handler is left
+		if (HasPending()) computer.yield = true;
+	}
+
+	void InterruptController::Reset()
+	{
+		Receive();
+
+		pending.clear();
+		in_service.clear();
+	}
+}
\ No newline at end of file
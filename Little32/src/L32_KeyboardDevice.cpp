@@ -1,30 +1,42 @@
 #include "L32_KeyboardDevice.h"
 
 #include "L32_Computer.h"
-#include "L32_ICore.h"
 #include "L32_IDeviceSettings.h"
 #include "L32_IMappedDevice.h"
 
 #include <events.hpp>
+#include <stdexcept>
 
 namespace Little32
 {
 	KeyboardDevice::KeyboardDevice(Computer& computer, word address)
 		: computer(computer), address_start(address)
 	{
+		interrupt_source = computer.interrupts.AddSource();
+
 		SDL::Input::RegisterEventType(SDL::Event::Type::KEYUP, *this);
 		SDL::Input::RegisterEventType(SDL::Event::Type::KEYDOWN, *this);
 	}
 
+	KeyboardDevice::~KeyboardDevice()
+	{
+		computer.interrupts.RemoveSource(interrupt_source);
+	}
+
 	void KeyboardDeviceFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path path) const
 	{
 		KeyboardDevice* device = new KeyboardDevice(computer, start_address);
+
+		computer.interrupts.SetPriority(device->interrupt_source, settings.GetInterruptPriority());
+
 		start_address += device->GetRange();
 		computer.AddMappedDevice(*device);
 	}
 
 	void KeyboardDeviceFactory::VerifySettings(const IDeviceSettings& settings, std::filesystem::path path) const
 	{
+		settings.VerifyInterruptPriority();
+
 		if (!settings.named_labels.empty())
 		{
 			throw std::runtime_error("Unknown named label: '" + settings.named_labels.begin()->first + "'");
@@ -42,7 +54,7 @@ namespace Little32
 
 		keys_down[down_head] = key;
 
-		computer.core->Interrupt(keydown_interrupt);
+		computer.interrupts.Post(interrupt_source, keydown_interrupt);
 	}
 
 	void KeyboardDevice::PushKeyUp(word key)
@@ -56,7 +68,7 @@ namespace Little32
 
 		keys_up[up_head] = key;
 
-		computer.core->Interrupt(keyup_interrupt);
+		computer.interrupts.Post(interrupt_source, keyup_interrupt);
 	}
 
 	word KeyboardDevice::PopKeyDown()
@@ -0,0 +1,199 @@
+#include "L32_L32AOTCore.h"
+
+#include "L32_Computer.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+// We don't want to inherit the min and max macros from windows
+#ifndef NOMINMAX
+#define NOMINMAX
+#include <Windows.h>
+#undef NOMINMAX
+#else
+#include <Windows.h>
+#endif // !NOMINMAX
+#else
+#include <dlfcn.h>
+#endif
+
+namespace Little32
+{
+	Little32AOTCore::Little32AOTCore(Computer& computer) :
+		Little32Core(computer)
+	{
+		// Blocks count instructions one at a time, so the interpreter mustn't run several at once
+		fuse_instructions = false;
+
+		context.registers = registers;
+		context.core = this;
+		context.read = ReadHelper;
+		context.read_byte = ReadByteHelper;
+		context.write = WriteHelper;
+		context.write_byte = WriteByteHelper;
+		context.interpret = InterpretHelper;
+	}
+
+	Little32AOTCore::~Little32AOTCore()
+	{
+		Unload();
+	}
+
+	void Little32AOTCore::Load(const std::filesystem::path& path)
+	{
+		Unload();
+
+#ifdef _WIN32
+		HMODULE handle = LoadLibraryW(path.c_str());
+		if (handle == nullptr) throw std::runtime_error("Could not load recompiled module '" + path.string() + "'");
+
+		const AOTModuleFunction get_module = reinterpret_cast<AOTModuleFunction>(GetProcAddress(handle, L32_AOT_MODULE_SYMBOL));
+#else
+		void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (handle == nullptr) throw std::runtime_error("Could not load recompiled module '" + path.string() + "' (" + dlerror() + ")");
+
+		const AOTModuleFunction get_module = reinterpret_cast<AOTModuleFunction>(dlsym(handle, L32_AOT_MODULE_SYMBOL));
+#endif
+
+		library = handle;
+
+		if (get_module == nullptr)
+		{
+			Unload();
+			throw std::runtime_error("'" + path.string() + "' is not a recompiled module");
+		}
+
+		const AOTModule* new_module = get_module();
+
+		if (new_module == nullptr || new_module->version != aot_module_version)
+		{
+			Unload();
+			throw std::runtime_error("'" + path.string() + "' was recompiled by a different version of Little32");
+		}
+
+		module = new_module;
+		block_table.assign(module->rom_size / sizeof(word), nullptr);
+
+		for (word i = 0; i < module->block_count; i++)
+		{
+			const AOTBlock& block = module->blocks[i];
+			const word index = (block.address - module->rom_start) / sizeof(word);
+
+			if (index < block_table.size()) block_table[index] = &block;
+		}
+
+		verify_pending = true;
+	}
+
+	void Little32AOTCore::Unload()
+	{
+		module = nullptr;
+		module_valid = false;
+		block_table.clear();
+
+		if (library == nullptr) return;
+
+#ifdef _WIN32
+		FreeLibrary(static_cast<HMODULE>(library));
+#else
+		dlclose(library);
+#endif
+
+		library = nullptr;
+	}
+
+	bool Little32AOTCore::Verify()
+	{
+		verify_pending = false;
+
+		if (module == nullptr) return false;
+
+		const word checksum = AOTChecksum([&](word i) { return computer.Read(module->rom_start + i * sizeof(word)); }, module->rom_size / sizeof(word));
+
+		return checksum == module->checksum;
+	}
+
+	void Little32AOTCore::InvalidateCache(word address, word range)
+	{
+		Little32Core::InvalidateCache(address, range);
+
+		if (module == nullptr) return;
+
+		// Overlaps if either range starts inside the other
+		if (address - module->rom_start < module->rom_size || module->rom_start - address < range) verify_pending = true;
+	}
+
+	void Little32AOTCore::FlushCache()
+	{
+		Little32Core::FlushCache();
+		verify_pending = true;
+	}
+
+	word Little32AOTCore::Run(word budget)
+	{
+		if (verify_pending) module_valid = Verify();
+
+		if (!module_valid) return Little32Core::Run(budget);
+
+		run_budget = run_left = budget;
+
+		while (run_left > 0)
+		{
+			const word index = (PC - module->rom_start) / sizeof(word);
+			const AOTBlock* block = PC % sizeof(word) == 0 && index < block_table.size() ? block_table[index] : nullptr;
+
+			// Blocks are run whole, so interpret whatever isn't recompiled or doesn't fit into the budget
+			if (block == nullptr || run_left < block->length)
+			{
+				// Counted before it runs, as the interpreter does
+				run_left--;
+				Little32Core::Clock();
+			}
+			else
+			{
+				context.flags = GetFlags();
+				run_left -= block->function(context);
+				SetFlags(context.flags);
+			}
+
+			if (computer.halted || computer.yield) break;
+		}
+
+		const word ran = run_budget - run_left;
+
+		run_budget = run_left = 0;
+
+		// Recompiled code doesn't run HaltHandler, so check where the run ended up
+		if (Little32Core::IsHalted()) computer.halted = true;
+		return ran;
+	}
+
+	word Little32AOTCore::ReadHelper(AOTContext& context, word address)
+	{
+		return static_cast<Little32AOTCore*>(context.core)->computer.Read(address);
+	}
+
+	word Little32AOTCore::ReadByteHelper(AOTContext& context, word address)
+	{
+		return static_cast<Little32AOTCore*>(context.core)->computer.ReadByte(address);
+	}
+
+	void Little32AOTCore::WriteHelper(AOTContext& context, word address, word value)
+	{
+		static_cast<Little32AOTCore*>(context.core)->computer.Write(address, value);
+	}
+
+	void Little32AOTCore::WriteByteHelper(AOTContext& context, word address, word value)
+	{
+		static_cast<Little32AOTCore*>(context.core)->computer.WriteByte(address, value);
+	}
+
+	void Little32AOTCore::InterpretHelper(AOTContext& context)
+	{
+		Little32AOTCore* core = static_cast<Little32AOTCore*>(context.core);
+
+		core->SetFlags(context.flags);
+		core->Little32Core::Clock();
+		context.flags = core->GetFlags();
+	}
+}
\ No newline at end of file
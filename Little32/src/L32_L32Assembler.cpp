@@ -2011,10 +2011,16 @@ namespace Little32
 				*cur_end = *cur_start;
 			}
 
-			for (word i = 0; i < size; i++)
-			{
-				computer->WriteByteForced(*current_address + *memory_start + i, 0);
-			}
+			const word addr = *current_address + *memory_start;
+			word i = 0;
+
+			// Whole words are cleared at once, and any bytes either side of them one at a time
+			for (; i < size && (addr + i) % sizeof(word) != 0; i++) computer->WriteByteForced(addr + i, 0);
+
+			const word words = (size - i) / sizeof(word);
+			computer->FillForced(addr + i, 0, words);
+
+			for (i += words * sizeof(word); i < size; i++) computer->WriteByteForced(addr + i, 0);
 
 			(*current_address) += size;
 
@@ -2774,6 +2780,10 @@ namespace Little32
 			printf("\n");
 		}
 
+		// Consecutive instructions are written to memory together
+		std::vector<word> block;
+		word block_start = 0;
+
 		for (auto& l : assembly_lines)
 		{
 			ResolveRelatives(l);
@@ -2933,9 +2943,18 @@ namespace Little32
 				break;
 			}
 
-			computer->WriteForced(l.addr, instruction);
+			if (!block.empty() && l.addr != block_start + block.size() * sizeof(word))
+			{
+				computer->WriteBlockForced(block_start, block.data(), (word)block.size());
+				block.clear();
+			}
+
+			if (block.empty()) block_start = l.addr;
+			block.push_back(instruction);
 		}
 
+		if (!block.empty()) computer->WriteBlockForced(block_start, block.data(), (word)block.size());
+
 		file_stack.pop_back();
 	}
 }
\ No newline at end of file
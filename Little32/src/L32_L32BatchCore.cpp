@@ -0,0 +1,323 @@
+#include "L32_L32BatchCore.h"
+
+#include "L32_Computer.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace Little32
+{
+	namespace
+	{
+		using Handler = Little32BatchCore::Handler;
+
+		// Indexed by (op << 3) | (immediate << 2) | (set_status << 1) | negative
+		template<size_t... I>
+		constexpr std::array<Handler, sizeof...(I)> MakeArithmeticHandlers(std::index_sequence<I...>)
+		{
+			return { &Little32BatchCore::ArithmeticHandler<(I >> 3), ((I >> 2) & 1) != 0, ((I >> 1) & 1) != 0, (I & 1) != 0>... };
+		}
+
+		constexpr auto arithmetic_handlers = MakeArithmeticHandlers(std::make_index_sequence<16 * 8>());
+
+		constexpr byte PC_index = 15;
+
+		/// <summary> A 64 bit value kept as two words, so that sums of 32 bit lanes stay in 32 bit lanes </summary>
+		struct Wide
+		{
+			word low;
+			word high;
+		};
+
+		constexpr Wide SignExtend(word value) { return { value, (word)((int32_t)value >> 31) }; }
+
+		// The carry out of the low words is 1 when their sum wrapped around
+		constexpr Wide Add(Wide a, Wide b)
+		{
+			const word low = a.low + b.low;
+			return { low, a.high + b.high + (word)(low < a.low) };
+		}
+
+		constexpr Wide Negate(Wide a) { return { 0 - a.low, ~a.high + (word)(a.low == 0) }; }
+	}
+
+	Little32BatchCore::Little32BatchCore(const Lanes<Little32Core*>& cores) :
+		cores(cores)
+	{
+		for (Little32Core* core : cores)
+		{
+			// Fused instructions would run several instructions in one step, and fall out of lockstep
+			core->fuse_instructions = false;
+			core->FlushCache();
+		}
+	}
+
+	void Little32BatchCore::SetSharedCode(word start, word size)
+	{
+		shared_start = start;
+		shared_size = size;
+		FlushCache();
+	}
+
+	void Little32BatchCore::FlushCache()
+	{
+		decode_cache.assign(shared_size / sizeof(word), {});
+	}
+
+	const Little32BatchCore::BatchInstruction* Little32BatchCore::Fetch(word address)
+	{
+		const word index = (address - shared_start) / sizeof(word);
+		if (address % sizeof(word) != 0 || index >= decode_cache.size()) return nullptr;
+
+		BatchInstruction& b = decode_cache[index];
+		if (b.d.valid) return &b;
+
+		// The shared code is the same on every machine, so any of them can be read from
+		b.d = Little32Core::Decode(cores[0]->computer.Read(address));
+		b.d.address = address;
+		b.d.valid = true;
+
+		const DecodedInstruction& d = b.d;
+
+		switch (d.type)
+		{
+			case DecodedInstruction::Type::ARITHMETIC:
+			{
+				// CMP, CMN and TST don't write to reg1
+				const bool writes_PC = d.reg1 == PC_index && d.op != 0b0110 && d.op != 0b0111 && d.op != 0b1011;
+				if (!writes_PC) b.handler = arithmetic_handlers[(d.op << 3) | (d.immediate << 2) | (d.set_status << 1) | d.negative];
+				break;
+			}
+			case DecodedInstruction::Type::BRANCH:
+				if (d.offset != 0 || !d.negative) b.handler = d.link ? &Little32BatchCore::BranchHandler<true> : &Little32BatchCore::BranchHandler<false>;
+				else if (d.link) b.handler = &Little32BatchCore::ReturnHandler;
+				// RFE pops from the stack, so is left to each core
+				break;
+			case DecodedInstruction::Type::NOP:
+				b.handler = &Little32BatchCore::NopHandler;
+				break;
+			default: // Memory accesses and floats are left to each core
+				break;
+		}
+
+		return &b;
+	}
+
+	void Little32BatchCore::Load(size_t lane)
+	{
+		const Little32Core& core = *cores[lane];
+
+		for (size_t r = 0; r < 16; r++) registers[r][lane] = core.registers[r];
+
+		flags[lane] = core.GetFlags();
+	}
+
+	void Little32BatchCore::Store(size_t lane)
+	{
+		Little32Core& core = *cores[lane];
+
+		for (size_t r = 0; r < 16; r++) core.registers[r] = registers[r][lane];
+
+		core.SetFlags(flags[lane]);
+	}
+
+	void Little32BatchCore::Run(word budget)
+	{
+		Lanes<word>& PC = registers[PC_index];
+		Lanes<word> remaining;
+		remaining.fill(budget);
+
+		for (size_t l = 0; l < lanes; l++) Load(l);
+
+		while (true)
+		{
+			// Follow the lanes with the lowest PC, so that lanes which branched ahead wait for the rest to catch up
+			// Lanes that have run out of budget count as being at the highest address
+			Lanes<word> live;
+			word address = ~(word)0;
+			word any = 0;
+
+			for (size_t l = 0; l < lanes; l++)
+			{
+				live[l] = 0 - (word)(remaining[l] != 0);
+				address = std::min(address, PC[l] | ~live[l]);
+				any |= live[l];
+			}
+
+			if (any == 0) break;
+
+			Lanes<word> active;
+			for (size_t l = 0; l < lanes; l++) active[l] = live[l] & (0 - (word)(PC[l] == address));
+
+			const BatchInstruction* b = Fetch(address);
+
+			if (b == nullptr || b->handler == nullptr)
+			{
+				for (size_t l = 0; l < lanes; l++)
+				{
+					if (active[l] == 0) continue;
+
+					Store(l);
+					cores[l]->Clock();
+					Load(l);
+
+					remaining[l]--;
+					scalar_steps++;
+				}
+
+				continue;
+			}
+
+			const DecodedInstruction& d = b->d;
+			const word condition_mask = Little32Core::condition_masks[d.cond];
+
+			// Lanes whose condition fails skip to the next instruction
+			Lanes<word> exec;
+			for (size_t l = 0; l < lanes; l++) exec[l] = active[l] & (0 - ((condition_mask >> flags[l]) & 1));
+
+			(this->*b->handler)(d, exec);
+
+			for (size_t l = 0; l < lanes; l++)
+			{
+				PC[l] += active[l] & ~exec[l] & (word)sizeof(word);
+				remaining[l] -= active[l] & 1;
+			}
+
+			vector_steps++;
+		}
+
+		for (size_t l = 0; l < lanes; l++) Store(l);
+	}
+
+	template<byte op, bool immediate, bool set_status, bool negative>
+	void Little32BatchCore::ArithmeticHandler(const DecodedInstruction& d, Lanes<word> exec)
+	{
+		using namespace std;
+		using enum Little32Core::FlagOp;
+
+		constexpr word neg = negative ? ~(word)0 : 0; // all 0s or 1s: Used for inverting values with ^, and with (x ^ neg) - neg for * -1
+
+		// CMP, CMN and TST only set the flags
+		constexpr bool compare = op == 0b0110 || op == 0b0111 || op == 0b1011;
+		constexpr bool shift = op == 0b0100 || op == 0b0101 || op == 0b1100 || op == 0b1101;
+		constexpr bool move = op == 0b1110 || op == 0b1111;
+
+		constexpr Little32Core::FlagOp flag_op =
+			op <= 0b0011 || op == 0b0110 ? ARITHMETIC :
+			op == 0b0111 ? CMN :
+			op == 0b0100 ? ASL :
+			op == 0b0101 ? ASR :
+			op == 0b1100 ? LSL :
+			op == 0b1101 ? LSR :
+			move ? MOVE :
+			LOGIC;
+
+		Lanes<word>& reg1 = registers[d.reg1];
+		const Lanes<word>& old = reg1;
+		const Lanes<word>& reg2 = registers[d.reg2];
+		const Lanes<word>& reg3 = registers[d.reg3];
+		const Lanes<word>& old_flags = flags;
+
+		// Results are only selected into place once every lane has read its operands, so the compiler can see that no lane reads what another wrote
+		Lanes<word> results;
+		Lanes<word> new_flags;
+
+		// Shifts compare against reg2 after reg1 was written, like the core does when they're the same register
+		const bool reg2_is_reg1 = d.reg2 == d.reg1;
+
+		// Mirrors Little32Core::ArithmeticHandler, a lane at a time. There are no branches or 64 bit values, so the compiler turns it into vector instructions
+		for (size_t l = 0; l < lanes; l++)
+		{
+			// Flexible operands: a constant if immediate, otherwise a register put through the barrel shift
+			const word val2 = immediate ? d.imm12 : rotl(reg2[l], d.shift);
+			const word val3 = immediate ? d.imm8 : rotl(reg3[l], d.shift);
+
+			word result = 0;
+			word operand = 0;
+
+			if constexpr (op <= 0b0011 || op == 0b0110 || op == 0b0111) // ADD, SUB, ADC, SBB, CMP, CMN
+			{
+				Wide sum;
+
+				if constexpr (op == 0b0110)      sum = Add(SignExtend(old[l]), Negate(SignExtend(val2))); // CMP
+				else if constexpr (op == 0b0111) sum = Add({ old[l], 0 }, SignExtend(val2));              // CMN, where reg1 is unsigned
+				else if constexpr (op & 1)       sum = Add(SignExtend(reg2[l]), Negate(SignExtend(val3)));
+				else                             sum = Add(SignExtend(reg2[l]), SignExtend(val3));
+
+				if constexpr (op == 0b0010 || op == 0b0011)
+				{
+					// 1, or -1 if N != V, when C is set
+					const word C = (old_flags[l] / Little32Core::C_flag) & 1;
+					const word NV = ((old_flags[l] / Little32Core::N_flag) ^ (old_flags[l] / Little32Core::V_flag)) & 1;
+					sum = Add(sum, SignExtend(C - ((C & NV) << 1)));
+				}
+
+				if constexpr (negative) sum = Negate(sum);
+
+				result = sum.low;
+				operand = sum.high;
+			}
+			else if constexpr (op == 0b0100) result = ((reg2[l] << (val3 & 31)) ^ neg) - neg;                             // ASL
+			else if constexpr (op == 0b0101) result = (((reg2[l] >> (val3 & 31)) | ~(~(word)0 >> (val3 & 31))) ^ neg) - neg; // ASR
+			else if constexpr (op == 0b1000) result = (reg2[l] | val3) ^ neg;         // ORR
+			else if constexpr (op == 0b1001) result = (reg2[l] & val3) ^ neg;         // AND
+			else if constexpr (op == 0b1010) result = (reg2[l] ^ val3) ^ neg;         // XOR
+			else if constexpr (op == 0b1011) result = old[l] & (val2 ^ neg);          // TST
+			else if constexpr (op == 0b1100) result = (reg2[l] << (val3 & 31)) ^ neg; // LSL
+			else if constexpr (op == 0b1101) result = (reg2[l] >> (val3 & 31)) ^ neg; // LSR
+			else if constexpr (op == 0b1110) result = val2 ^ neg;                     // MOV
+			else if constexpr (op == 0b1111) result = (~val2 + 1) ^ neg;              // INV
+
+			results[l] = result;
+
+			if constexpr (set_status || compare)
+			{
+				if constexpr (shift) operand = reg2_is_reg1 ? (result & exec[l]) | (old[l] & ~exec[l]) : reg2[l];
+				if constexpr (move) operand = old[l];
+
+				// Shifts are masked like x86 does, as the core inherits that from its host
+				new_flags[l] = Little32Core::EvaluateFlags<flag_op>(result, operand, shift ? val3 & 31 : 0, shift && negative);
+			}
+		}
+
+		for (size_t l = 0; l < lanes; l++)
+		{
+			if constexpr (!compare) reg1[l] = (results[l] & exec[l]) | (reg1[l] & ~exec[l]);
+			if constexpr (set_status || compare) flags[l] = (new_flags[l] & exec[l]) | (flags[l] & ~exec[l]);
+		}
+
+		NopHandler(d, exec);
+	}
+
+	// exec is passed by value, so the compiler can see that it isn't one of the registers these write to
+
+	template<bool link>
+	void Little32BatchCore::BranchHandler(const DecodedInstruction& d, Lanes<word> exec) // B / BL
+	{
+		Lanes<word>& PC = registers[PC_index];
+		Lanes<word>& LR = registers[14];
+		const word offset = d.offset;
+
+		for (size_t l = 0; l < lanes; l++)
+		{
+			if constexpr (link) LR[l] = ((PC[l] + (word)sizeof(word)) & exec[l]) | (LR[l] & ~exec[l]);
+			PC[l] += offset & exec[l];
+		}
+	}
+
+	void Little32BatchCore::ReturnHandler(const DecodedInstruction&, Lanes<word> exec) // RET
+	{
+		Lanes<word>& PC = registers[PC_index];
+		const Lanes<word>& LR = registers[14];
+
+		for (size_t l = 0; l < lanes; l++) PC[l] = (LR[l] & exec[l]) | (PC[l] & ~exec[l]);
+	}
+
+	void Little32BatchCore::NopHandler(const DecodedInstruction&, Lanes<word> exec)
+	{
+		Lanes<word>& PC = registers[PC_index];
+
+		for (size_t l = 0; l < lanes; l++) PC[l] += exec[l] & (word)sizeof(word);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,966 @@
+#include "L32_L32JITCore.h"
+
+#include "L32_Computer.h"
+#include "L32_IMappedDevice.h"
+#include "L32_RAM.h"
+#include "L32_ROM.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#if L32_JIT_SUPPORTED
+#ifdef _WIN32
+// We don't want to inherit the min and max macros from windows
+#ifndef NOMINMAX
+#define NOMINMAX
+#include <Windows.h>
+#undef NOMINMAX
+#else
+#include <Windows.h>
+#endif // !NOMINMAX
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+namespace Little32
+{
+#if L32_JIT_SUPPORTED
+	namespace
+	{
+		enum X64Reg : byte { X64_RAX, X64_RCX, X64_RDX, X64_RBX, X64_RSP, X64_RBP, X64_RSI, X64_RDI, X64_R8, X64_R9, X64_R10, X64_R11, X64_R12, X64_R13, X64_R14, X64_R15 };
+
+		enum X64Cond : byte
+		{
+			X64_AE = 0x3, // Carry clear
+			X64_E  = 0x4,
+			X64_NE = 0x5,
+			X64_A  = 0x7, // Unsigned >
+			X64_S  = 0x8,
+			X64_L  = 0xC
+		};
+
+		// The 'ext' field of the group 1 arithmetic instructions
+		enum X64AluOp : byte
+		{
+			X64_ADD = 0,
+			X64_OR  = 1,
+			X64_AND = 4,
+			X64_SUB = 5,
+			X64_XOR = 6,
+			X64_CMP = 7
+		};
+
+#ifdef _WIN32
+		constexpr X64Reg ARG0 = X64_RCX, ARG1 = X64_RDX, ARG2 = X64_R8;
+#else
+		constexpr X64Reg ARG0 = X64_RDI, ARG1 = X64_RSI, ARG2 = X64_RDX;
+#endif
+
+		// Callee saved registers that hold guest state while translated code runs
+		constexpr X64Reg REGS   = X64_RBX; // Address of the guest registers
+		constexpr X64Reg FLAGS  = X64_R12; // NZCV, packed like the status word pushed by an interrupt
+		constexpr X64Reg BUDGET = X64_R13; // Instructions left to run
+
+		constexpr int32_t PC_offset = 15 * sizeof(word);
+		constexpr int32_t LR_offset = 14 * sizeof(word);
+
+		// Upper bound on the code generated for one instruction, including its share of the block's exits
+		constexpr size_t max_instruction_bytes = 512;
+
+		struct X64Emitter
+		{
+			byte* cur;
+			byte* end;
+
+			inline void Byte(byte b) { if (cur < end) *cur++ = b; }
+			inline void Dword(uint32_t v) { for (int i = 0; i < 4; i++) Byte(v >> (i * 8)); }
+			inline void Qword(uint64_t v) { Dword((uint32_t)v); Dword((uint32_t)(v >> 32)); }
+
+			void Rex(bool w, byte reg, byte index, byte base)
+			{
+				const byte rex = 0x40 | (w << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+				if (rex != 0x40) Byte(rex);
+			}
+
+			// op reg, rm
+			void RR(bool w, std::initializer_list<byte> op, byte reg, byte rm)
+			{
+				Rex(w, reg, 0, rm);
+				for (byte b : op) Byte(b);
+				Byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+			}
+
+			// op reg, [base + disp]
+			void RM(bool w, std::initializer_list<byte> op, byte reg, byte base, int32_t disp)
+			{
+				Rex(w, reg, 0, base);
+				for (byte b : op) Byte(b);
+
+				const byte mod = (disp == 0 && (base & 7) != X64_RBP) ? 0x00 : (disp >= -128 && disp <= 127) ? 0x40 : 0x80;
+
+				Byte(mod | ((reg & 7) << 3) | (base & 7));
+				if ((base & 7) == X64_RSP) Byte(0x24);
+
+				if (mod == 0x40) Byte((byte)disp);
+				else if (mod == 0x80) Dword(disp);
+			}
+
+			// op reg, [base + index], base can't be X64_RBP or X64_R13
+			void RI(bool w, std::initializer_list<byte> op, byte reg, byte base, byte index)
+			{
+				Rex(w, reg, index, base);
+				for (byte b : op) Byte(b);
+				Byte(0x04 | ((reg & 7) << 3));
+				Byte(((index & 7) << 3) | (base & 7));
+			}
+
+			inline void Mov(X64Reg dst, X64Reg src) { RR(false, { 0x8B }, dst, src); }
+			inline void MovImm(X64Reg dst, word imm) { Rex(false, 0, 0, dst); Byte(0xB8 + (dst & 7)); Dword(imm); }
+			inline void MovImm64(X64Reg dst, const void* imm) { Rex(true, 0, 0, dst); Byte(0xB8 + (dst & 7)); Qword((uint64_t)imm); }
+			inline void Movsxd(X64Reg dst, X64Reg src) { RR(true, { 0x63 }, dst, src); }
+			inline void Movzx8(X64Reg dst, X64Reg src) { RR(false, { 0x0F, 0xB6 }, dst, src); }
+
+			inline void Load(X64Reg dst, X64Reg base, int32_t disp) { RM(false, { 0x8B }, dst, base, disp); }
+			inline void Load64(X64Reg dst, X64Reg base, int32_t disp) { RM(true, { 0x8B }, dst, base, disp); }
+			inline void Store(X64Reg base, int32_t disp, X64Reg src) { RM(false, { 0x89 }, src, base, disp); }
+			inline void Store64(X64Reg base, int32_t disp, X64Reg src) { RM(true, { 0x89 }, src, base, disp); }
+			inline void StoreImm(X64Reg base, int32_t disp, word imm) { RM(false, { 0xC7 }, 0, base, disp); Dword(imm); }
+			inline void CmpImm(X64Reg base, int32_t disp, word imm) { RM(false, { 0x81 }, X64_CMP, base, disp); Dword(imm); }
+
+			inline void Alu(X64AluOp op, bool w, X64Reg dst, X64Reg src) { RR(w, { (byte)(op * 8 + 1) }, src, dst); }
+			inline void AluImm(X64AluOp op, bool w, X64Reg dst, word imm) { RR(w, { 0x81 }, op, dst); Dword(imm); }
+
+			inline void Not(X64Reg r) { RR(false, { 0xF7 }, 2, r); }
+			inline void Neg(bool w, X64Reg r) { RR(w, { 0xF7 }, 3, r); }
+			inline void Rol(X64Reg r, byte n) { if (n == 0) return; RR(false, { 0xC1 }, 0, r); Byte(n); }
+			inline void Shl(bool w, X64Reg r, byte n) { RR(w, { 0xC1 }, 4, r); Byte(n); }
+			inline void Shr(bool w, X64Reg r, byte n) { RR(w, { 0xC1 }, 5, r); Byte(n); }
+			inline void ShlCL(X64Reg r) { RR(false, { 0xD3 }, 4, r); }
+			inline void ShrCL(X64Reg r) { RR(false, { 0xD3 }, 5, r); }
+
+			inline void Test(bool w, X64Reg a, X64Reg b) { RR(w, { 0x85 }, b, a); }
+			inline void TestAL(byte imm) { Byte(0xA8); Byte(imm); }
+			// Only for AL, CL, DL and BL
+			inline void Set(X64Cond cc, X64Reg r) { RR(false, { 0x0F, (byte)(0x90 | cc) }, 0, r); }
+			// Sets the carry flag to bit b of a
+			inline void Bt(X64Reg a, X64Reg b) { RR(false, { 0x0F, 0xA3 }, b, a); }
+
+			inline byte* Jcc(X64Cond cc) { Byte(0x0F); Byte(0x80 | cc); Dword(0); return cur - 4; }
+			inline byte* Jmp() { Byte(0xE9); Dword(0); return cur - 4; }
+			inline void JmpReg(X64Reg r) { RR(false, { 0xFF }, 4, r); }
+			inline void Call(const void* fn) { MovImm64(X64_RAX, fn); RR(false, { 0xFF }, 2, X64_RAX); }
+
+			inline void Push(X64Reg r) { if (r & 8) Byte(0x41); Byte(0x50 + (r & 7)); }
+			inline void Pop(X64Reg r) { if (r & 8) Byte(0x41); Byte(0x58 + (r & 7)); }
+			inline void Ret() { Byte(0xC3); }
+
+			// Points a rel32 from Jcc or Jmp at target
+			static void Bind(byte* site, const byte* target)
+			{
+				const int32_t rel = (int32_t)(target - (site + 4));
+				memcpy(site, &rel, sizeof(rel));
+			}
+
+			inline void Bind(byte* site) { Bind(site, cur); }
+		};
+
+		/// <summary> A jump out of a block that still needs its code emitting </summary>
+		struct PendingExit
+		{
+			byte* site;
+			word PC;
+			word refund;  // Instructions to give back to the budget because they weren't run
+			bool set_PC;  // False if the PC has already been stored
+		};
+	}
+
+	Little32JITCore::Little32JITCore(Computer& computer) :
+		Little32Core(computer),
+		block_lookup(block_lookup_size, nullptr)
+	{
+		// Blocks count instructions one at a time, so the interpreter mustn't run several at once
+		fuse_instructions = false;
+
+#ifdef _WIN32
+		code_buffer = static_cast<byte*>(VirtualAlloc(nullptr, code_buffer_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+		void* mem = mmap(nullptr, code_buffer_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		code_buffer = mem == MAP_FAILED ? nullptr : static_cast<byte*>(mem);
+#endif
+
+		if (code_buffer != nullptr) EmitTrampolines();
+	}
+
+	Little32JITCore::~Little32JITCore()
+	{
+		if (code_buffer == nullptr) return;
+
+#ifdef _WIN32
+		VirtualFree(code_buffer, 0, MEM_RELEASE);
+#else
+		munmap(code_buffer, code_buffer_size);
+#endif
+	}
+
+	void Little32JITCore::EmitTrampolines()
+	{
+		X64Emitter e { code_buffer, code_buffer + code_buffer_size };
+
+		// Entry: saves the host registers, loads the guest state and jumps to the block passed in
+		enter_code = reinterpret_cast<void(*)(byte*)>(e.cur);
+
+		e.Push(X64_RBX);
+		e.Push(X64_RBP);
+		e.Push(X64_R12);
+		e.Push(X64_R13);
+		e.Push(X64_R14);
+		e.Push(X64_R15);
+		e.RR(true, { 0x83 }, X64_SUB, X64_RSP); e.Byte(40); // Shadow space for calls, and keeps the stack 16 byte aligned
+
+		e.MovImm64(REGS, registers);
+		e.MovImm64(X64_RAX, &jit_flags);
+		e.Load(FLAGS, X64_RAX, 0);
+		e.MovImm64(X64_RAX, &jit_budget);
+		e.Load64(BUDGET, X64_RAX, 0);
+		e.JmpReg(ARG0);
+
+		// Exit: X64_RAX holds the exit taken if it can be linked, otherwise null
+		exit_code = e.cur;
+
+		e.MovImm64(X64_RCX, &last_exit);
+		e.Store64(X64_RCX, 0, X64_RAX);
+		e.MovImm64(X64_RCX, &jit_flags);
+		e.Store(X64_RCX, 0, FLAGS);
+		e.MovImm64(X64_RCX, &jit_budget);
+		e.Store64(X64_RCX, 0, BUDGET);
+
+		e.RR(true, { 0x83 }, X64_ADD, X64_RSP); e.Byte(40);
+		e.Pop(X64_R15);
+		e.Pop(X64_R14);
+		e.Pop(X64_R13);
+		e.Pop(X64_R12);
+		e.Pop(X64_RBP);
+		e.Pop(X64_RBX);
+		e.Ret();
+
+		code_start = code_current = e.cur;
+	}
+#endif
+
+	void Little32JITCore::InvalidateCache(word address, word range)
+	{
+		Little32Core::InvalidateCache(address, range);
+
+		if (code_pages.empty() || range == 0) return;
+
+		// Ranges can wrap around the end of memory
+		const uint64_t last = ((uint64_t)address + range - 1) >> code_page_bits;
+
+		for (uint64_t page = address >> code_page_bits; page <= last; page++)
+		{
+			if (code_pages.contains((word)page & (~(word)0 >> code_page_bits)))
+			{
+				flush_pending = code_modified = true;
+				return;
+			}
+		}
+	}
+
+	void Little32JITCore::FlushCache()
+	{
+		Little32Core::FlushCache();
+		flush_pending = code_modified = true;
+	}
+
+	word Little32JITCore::Run(word budget)
+	{
+#if L32_JIT_SUPPORTED
+		if (code_buffer != nullptr)
+		{
+			jit_budget = budget;
+			jit_run_budget = budget;
+
+			while (jit_budget > 0)
+			{
+				if (flush_pending) FlushBlocks();
+
+				Block* block = FindBlock(PC);
+				if (block == nullptr) block = Compile(PC);
+
+				// Blocks are run whole, so interpret whatever doesn't fit into the budget
+				if (jit_budget < block->length)
+				{
+					last_exit = nullptr;
+					// Counted before it runs, as the interpreter does
+					jit_budget--;
+					Little32Core::Clock();
+
+					if (computer.halted || computer.yield) break;
+					continue;
+				}
+
+				// Jump straight here from the block that just exited, next time it's run
+				if (last_exit != nullptr && last_exit->patch_site != nullptr && last_exit->target == PC)
+				{
+					last_exit->patch_site[0] = 0xE9; // JMP rel32
+					X64Emitter::Bind(last_exit->patch_site + 1, block->code);
+					last_exit->patch_site = nullptr;
+				}
+				last_exit = nullptr;
+
+				jit_flags = GetFlags();
+				enter_code(block->code);
+				SetFlags(jit_flags);
+
+				// Translated code leaves as soon as a helper sees either, rather than carrying on into linked blocks
+				if (computer.halted || computer.yield) break;
+			}
+
+			const word ran = budget - (word)jit_budget;
+
+			jit_budget = 0;
+			jit_run_budget = 0;
+
+			// Translated code doesn't run HaltHandler, so check where the run ended up
+			if (Little32Core::IsHalted()) computer.halted = true;
+			return ran;
+		}
+#endif
+
+		return Little32Core::Run(budget);
+	}
+
+#if L32_JIT_SUPPORTED
+	void Little32JITCore::FlushBlocks()
+	{
+		blocks.clear();
+		std::fill(block_lookup.begin(), block_lookup.end(), nullptr);
+		block_exits.clear();
+		code_pages.clear();
+		last_exit = nullptr;
+		code_current = code_start;
+
+		// Translated code stores straight into memory without telling the interpreter, so its decoded instructions go too
+		Little32Core::FlushCache();
+		CollectRegions();
+
+		flush_pending = code_modified = false;
+	}
+
+	void Little32JITCore::CollectRegions()
+	{
+		regions.clear();
+
+		std::vector<IMemoryMapped*> mapped(computer.mappings.begin(), computer.mappings.end());
+		mapped.insert(mapped.end(), computer.mapped_devices.begin(), computer.mapped_devices.end());
+
+		for (IMemoryMapped* m : mapped)
+		{
+			const Device_ID id = m->GetID();
+			if (id != RAM_DEVICE && id != ROM_DEVICE) continue;
+
+			const uint64_t start = m->GetAddress();
+			const uint64_t end = start + m->GetRange();
+
+			if (end - start < sizeof(word) || end > 0xFFFFFFFF) continue;
+
+			// Overlapping devices are combined by the bus, so they have to go through it
+			bool overlapped = false;
+			for (IMemoryMapped* other : mapped)
+			{
+				if (other == m || other->GetRange() == 0) continue;
+
+				const uint64_t other_start = other->GetAddress();
+				const uint64_t other_end = other_start + other->GetRange();
+
+				if (other_start < end && start < other_end)
+				{
+					overlapped = true;
+					break;
+				}
+			}
+			if (overlapped) continue;
+
+			MemoryRegion& region = regions.emplace_back();
+			region.start = (word)start;
+			region.size = (word)(end - start);
+			region.code_map.resize(((region.size - 1) >> code_page_bits) + 1);
+
+			if (id == RAM_DEVICE)
+			{
+				region.memory = reinterpret_cast<byte*>(static_cast<RAM*>(m)->memory.get());
+				region.dirty_pages = static_cast<RAM*>(m)->dirty_pages.get();
+				region.writable = true;
+			}
+			else
+			{
+				region.memory = reinterpret_cast<byte*>(static_cast<ROM*>(m)->memory.get());
+			}
+
+			// Every access checks each region in turn, so only the first few are worth it
+			if (regions.size() == 4) break;
+		}
+	}
+
+	Little32JITCore::Block* Little32JITCore::FindBlock(word address)
+	{
+		Block*& slot = block_lookup[(address / sizeof(word)) & (block_lookup_size - 1)];
+
+		if (slot != nullptr && slot->address == address) return slot;
+
+		auto it = blocks.find(address);
+		if (it == blocks.end()) return nullptr;
+
+		return slot = &it->second;
+	}
+
+	word Little32JITCore::ReadHelper(Little32JITCore* core, word address)
+	{
+		return core->computer.Read(address);
+	}
+
+	word Little32JITCore::ReadByteHelper(Little32JITCore* core, word address)
+	{
+		return core->computer.ReadByte(address);
+	}
+
+	word Little32JITCore::WriteHelper(Little32JITCore* core, word address, word value)
+	{
+		core->computer.Write(address, value);
+
+		const bool modified = core->code_modified;
+		core->code_modified = false;
+
+		// Devices written to may be scheduled sooner than the run was meant to go on for
+		return modified || core->computer.yield;
+	}
+
+	word Little32JITCore::WriteByteHelper(Little32JITCore* core, word address, word value)
+	{
+		core->computer.WriteByte(address, value);
+
+		const bool modified = core->code_modified;
+		core->code_modified = false;
+		return modified || core->computer.yield;
+	}
+
+	word Little32JITCore::InterpretHelper(Little32JITCore* core, word address, word flags)
+	{
+		core->PC = address;
+		core->SetFlags(flags);
+		core->Little32Core::Clock();
+
+		const bool modified = core->code_modified;
+		core->code_modified = false;
+
+		// The top bit tells the block to stop, as its code may have been overwritten, or the computer wants the run to end
+		const bool stop = modified || core->computer.yield || core->computer.halted;
+		return core->GetFlags() | (stop ? 0x80000000 : 0);
+	}
+
+	Little32JITCore::Block* Little32JITCore::Compile(word address)
+	{
+		using Type = DecodedInstruction::Type;
+
+		// Decode first so the length of the block is known up front
+		DecodedInstruction instructions[max_block_length];
+		word length = 0;
+
+		while (length < max_block_length)
+		{
+			const word instruction_address = address + length * sizeof(word);
+
+			DecodedInstruction& d = instructions[length++];
+			d = Decode(computer.Read(instruction_address));
+			d.address = instruction_address;
+			d.valid = true;
+
+			if (d.type == Type::BRANCH) break;
+		}
+
+		if ((size_t)(code_buffer + code_buffer_size - code_current) < (length + 2) * max_instruction_bytes) FlushBlocks();
+
+		// Remember where this code came from, so that writes to it are caught
+		for (word i = 0; i < length; i++)
+		{
+			const word first = instructions[i].address;
+			const word last = first + sizeof(word) - 1;
+
+			code_pages.insert(first >> code_page_bits);
+			code_pages.insert(last >> code_page_bits);
+
+			for (MemoryRegion& region : regions)
+			{
+				if (first - region.start < region.size) region.code_map[(first - region.start) >> code_page_bits] = 1;
+				if (last - region.start < region.size) region.code_map[(last - region.start) >> code_page_bits] = 1;
+			}
+		}
+
+		Block& block = blocks[address];
+		block.address = address;
+		block.length = length;
+		block.code = code_current;
+
+		block_lookup[(address / sizeof(word)) & (block_lookup_size - 1)] = &block;
+
+		X64Emitter e { code_current, code_buffer + code_buffer_size };
+		std::vector<PendingExit> exits;
+
+		// Leaves the block through a jump that can later be linked to the next block
+		const auto EmitLinkableExit = [&](word target)
+		{
+			BlockExit& exit = block_exits.emplace_back();
+			exit.patch_site = e.cur;
+			exit.target = target;
+
+			e.StoreImm(REGS, PC_offset, target); // Long enough to be overwritten by a JMP rel32
+			e.MovImm64(X64_RAX, &exit);
+			X64Emitter::Bind(e.Jmp(), exit_code);
+		};
+
+		const auto LoadReg = [&](X64Reg dst, byte reg, word pc)
+		{
+			// The PC is only kept up to date between blocks
+			if (reg == 15) e.MovImm(dst, pc);
+			else e.Load(dst, REGS, reg * sizeof(word));
+		};
+
+		// val2 of arithmetic instructions
+		const auto LoadOperand2 = [&](X64Reg dst, const DecodedInstruction& d)
+		{
+			if (d.immediate) return e.MovImm(dst, d.imm12);
+			LoadReg(dst, d.reg2, d.address);
+			e.Rol(dst, d.shift);
+		};
+
+		// val3 of arithmetic instructions
+		const auto LoadOperand3 = [&](X64Reg dst, const DecodedInstruction& d)
+		{
+			if (d.immediate) return e.MovImm(dst, d.imm8);
+			LoadReg(dst, d.reg3, d.address);
+			e.Rol(dst, d.shift);
+		};
+
+		// N and Z from EAX, C and V cleared
+		const auto EmitLogicFlags = [&]()
+		{
+			e.Test(false, X64_RAX, X64_RAX);
+			e.Set(X64_S, X64_RCX);
+			e.Set(X64_E, X64_RDX);
+			e.Movzx8(X64_RCX, X64_RCX);
+			e.Shl(false, X64_RCX, 3);
+			e.Movzx8(X64_RDX, X64_RDX);
+			e.Shl(false, X64_RDX, 2);
+			e.Alu(X64_OR, false, X64_RCX, X64_RDX);
+			e.Mov(FLAGS, X64_RCX);
+		};
+
+		// N and Z from EAX, V from the signs of EAX and X64_RAX, and C either from truncating X64_RAX or from bit 32 of X64_RAX
+		const auto EmitArithmeticFlags = [&](bool carry_out)
+		{
+			e.Mov(X64_R8, X64_RAX);
+			e.Shr(false, X64_R8, 31); // N
+			e.RR(true, { 0x8B }, X64_R9, X64_RAX);
+			e.Shr(true, X64_R9, 63);
+			e.Alu(X64_XOR, false, X64_R9, X64_R8); // V
+			e.Shl(false, X64_R8, 3);
+			e.Alu(X64_OR, false, X64_R8, X64_R9);
+
+			e.Test(false, X64_RAX, X64_RAX);
+			e.Set(X64_E, X64_RCX);
+			e.Movzx8(X64_RCX, X64_RCX);
+			e.Shl(false, X64_RCX, 2);
+			e.Alu(X64_OR, false, X64_R8, X64_RCX); // Z
+
+			if (carry_out)
+			{
+				e.RR(true, { 0x8B }, X64_RCX, X64_RAX);
+				e.Shr(true, X64_RCX, 32);
+				e.AluImm(X64_AND, false, X64_RCX, 1);
+			}
+			else
+			{
+				e.Movsxd(X64_RCX, X64_RAX);
+				e.Alu(X64_CMP, true, X64_RCX, X64_RAX);
+				e.Set(X64_NE, X64_RCX);
+				e.Movzx8(X64_RCX, X64_RCX);
+			}
+			e.Shl(false, X64_RCX, 1);
+			e.Alu(X64_OR, false, X64_R8, X64_RCX); // C
+
+			e.Mov(FLAGS, X64_R8);
+		};
+
+		// Z from EAX, V from the signs of EAX and R8D (the old value), N and C cleared
+		const auto EmitMoveFlags = [&]()
+		{
+			e.Alu(X64_XOR, false, X64_R8, X64_RAX);
+			e.Shr(false, X64_R8, 31); // V
+			e.Test(false, X64_RAX, X64_RAX);
+			e.Set(X64_E, X64_RCX);
+			e.Movzx8(X64_RCX, X64_RCX);
+			e.Shl(false, X64_RCX, 2);
+			e.Alu(X64_OR, false, X64_R8, X64_RCX); // Z
+			e.Mov(FLAGS, X64_R8);
+		};
+
+		// Address of a load or store into EAX
+		const auto EmitAddress = [&](const DecodedInstruction& d)
+		{
+			LoadReg(X64_RAX, d.reg2, d.address);
+
+			if (d.op & 1)
+			{
+				const word offset = d.imm8 * (d.negative ? -1 : 1);
+				if (offset != 0) e.AluImm(X64_ADD, false, X64_RAX, offset);
+			}
+			else
+			{
+				LoadReg(X64_RCX, d.reg3, d.address);
+				e.Rol(X64_RCX, d.shift);
+				if (d.negative) e.Neg(false, X64_RCX);
+				e.Alu(X64_ADD, false, X64_RAX, X64_RCX);
+			}
+		};
+
+		// Helpers can ask the computer what cycle it is, so they're given the budget as if the instructions after this one weren't taken from it yet
+		const auto EmitStoreBudget = [&](word refund)
+		{
+			e.RR(true, { 0x8B }, X64_R10, BUDGET);
+			if (refund != 0) e.AluImm(X64_ADD, true, X64_R10, refund);
+			e.MovImm64(X64_R11, &jit_budget);
+			e.Store64(X64_R11, 0, X64_R10);
+		};
+
+		// Reads from the address in EAX into EAX
+		const auto EmitRead = [&](bool byte_access, word refund)
+		{
+			std::vector<byte*> to_slow, to_done;
+
+			// Unaligned word reads only return a byte from RAM and ROM, so leave them to the bus
+			if (!byte_access && !regions.empty())
+			{
+				e.TestAL(sizeof(word) - 1);
+				to_slow.push_back(e.Jcc(X64_NE));
+			}
+
+			for (const MemoryRegion& region : regions)
+			{
+				e.Mov(X64_RCX, X64_RAX);
+				e.AluImm(X64_SUB, false, X64_RCX, region.start);
+				e.AluImm(X64_CMP, false, X64_RCX, region.size - (byte_access ? 1 : sizeof(word)));
+				byte* next = e.Jcc(X64_A);
+
+				e.MovImm64(X64_RDX, region.memory);
+				if (byte_access) e.RI(false, { 0x0F, 0xB6 }, X64_RAX, X64_RDX, X64_RCX);
+				else e.RI(false, { 0x8B }, X64_RAX, X64_RDX, X64_RCX);
+				to_done.push_back(e.Jmp());
+
+				e.Bind(next);
+			}
+
+			for (byte* site : to_slow) e.Bind(site);
+
+			EmitStoreBudget(refund);
+			e.Mov(ARG1, X64_RAX);
+			e.MovImm64(ARG0, this);
+			e.Call(reinterpret_cast<const void*>(byte_access ? &ReadByteHelper : &ReadHelper));
+
+			for (byte* site : to_done) e.Bind(site);
+		};
+
+		// Writes R9D to the address in EAX, stopping the block if it wrote over translated code
+		const auto EmitWrite = [&](bool byte_access, word next_PC, word refund)
+		{
+			std::vector<byte*> to_slow, to_done;
+
+			if (!byte_access && !regions.empty())
+			{
+				e.TestAL(sizeof(word) - 1);
+				to_slow.push_back(e.Jcc(X64_NE));
+			}
+
+			for (const MemoryRegion& region : regions)
+			{
+				if (!region.writable) continue;
+
+				e.Mov(X64_RCX, X64_RAX);
+				e.AluImm(X64_SUB, false, X64_RCX, region.start);
+				e.AluImm(X64_CMP, false, X64_RCX, region.size - (byte_access ? 1 : sizeof(word)));
+				byte* next = e.Jcc(X64_A);
+
+				// Pages holding translated code go through the bus, which invalidates it
+				e.Mov(X64_R10, X64_RCX);
+				e.Shr(false, X64_R10, code_page_bits);
+				e.MovImm64(X64_RDX, region.code_map.data());
+				e.RI(false, { 0x80 }, X64_CMP, X64_RDX, X64_R10); e.Byte(0);
+				to_slow.push_back(e.Jcc(X64_NE));
+
+				// So do pages the RAM hasn't seen written to, so that it knows to restore them on reset
+				e.Mov(X64_R10, X64_RCX);
+				e.Shr(false, X64_R10, RAM::dirty_page_bits);
+				e.MovImm64(X64_RDX, region.dirty_pages);
+				e.RI(false, { 0x80 }, X64_CMP, X64_RDX, X64_R10); e.Byte(0);
+				to_slow.push_back(e.Jcc(X64_E));
+
+				e.MovImm64(X64_RDX, region.memory);
+				if (byte_access) e.RI(false, { 0x88 }, X64_R9, X64_RDX, X64_RCX);
+				else e.RI(false, { 0x89 }, X64_R9, X64_RDX, X64_RCX);
+				to_done.push_back(e.Jmp());
+
+				e.Bind(next);
+			}
+
+			for (byte* site : to_slow) e.Bind(site);
+
+			EmitStoreBudget(refund);
+			e.Mov(ARG2, X64_R9);
+			e.Mov(ARG1, X64_RAX);
+			e.MovImm64(ARG0, this);
+			e.Call(reinterpret_cast<const void*>(byte_access ? &WriteByteHelper : &WriteHelper));
+			e.Test(false, X64_RAX, X64_RAX);
+			exits.push_back({ e.Jcc(X64_NE), next_PC, refund, true });
+
+			for (byte* site : to_done) e.Bind(site);
+		};
+
+		// Hands a single instruction to the interpreter
+		const auto EmitInterpret = [&](const DecodedInstruction& d, word refund)
+		{
+			EmitStoreBudget(refund);
+			e.Mov(ARG2, FLAGS);
+			e.MovImm(ARG1, d.address);
+			e.MovImm64(ARG0, this);
+			e.Call(reinterpret_cast<const void*>(&InterpretHelper));
+
+			e.Mov(FLAGS, X64_RAX);
+			e.AluImm(X64_AND, false, FLAGS, 0xF);
+
+			e.Test(false, X64_RAX, X64_RAX);
+			exits.push_back({ e.Jcc(X64_S), 0, refund, false });
+
+			e.CmpImm(REGS, PC_offset, d.address + sizeof(word));
+			exits.push_back({ e.Jcc(X64_NE), 0, refund, false });
+		};
+
+		// Stop before starting the block if there isn't enough budget left for all of it
+		e.RR(true, { 0x81 }, X64_CMP, BUDGET); e.Dword(length);
+		exits.push_back({ e.Jcc(X64_L), address, 0, true });
+		e.RR(true, { 0x81 }, X64_SUB, BUDGET); e.Dword(length);
+
+		bool ended = false;
+
+		for (word i = 0; i < length; i++)
+		{
+			const DecodedInstruction& d = instructions[i];
+			const word refund = length - i - 1;
+			const word next_PC = d.address + sizeof(word);
+
+			if (d.type == Type::BRANCH && !(d.negative && d.offset == 0))
+			{
+				// B / BL
+				ended = true;
+
+				if (d.cond == 0xF)
+				{
+					EmitLinkableExit(next_PC);
+					break;
+				}
+
+				if (d.cond != AL)
+				{
+					e.MovImm(X64_RAX, condition_masks[d.cond]);
+					e.Bt(X64_RAX, FLAGS);
+					byte* not_taken = e.Jcc(X64_AE);
+
+					if (d.link) e.StoreImm(REGS, LR_offset, next_PC);
+					EmitLinkableExit(d.address + d.offset);
+
+					e.Bind(not_taken);
+					EmitLinkableExit(next_PC);
+				}
+				else
+				{
+					if (d.link) e.StoreImm(REGS, LR_offset, next_PC);
+					EmitLinkableExit(d.address + d.offset);
+				}
+				break;
+			}
+
+			bool inline_op = false;
+
+			if (d.type == Type::NOP) continue;
+			else if (d.type == Type::ARITHMETIC)
+			{
+				switch (d.op)
+				{
+					case 0b0110: // CMP
+					case 0b0111: // CMN
+					case 0b1011: // TST
+						inline_op = true;
+						break;
+					case 0b0000: // ADD
+					case 0b0001: // SUB
+					case 0b1000: // ORR
+					case 0b1001: // AND
+					case 0b1010: // XOR
+					case 0b1110: // MOV
+					case 0b1111: // INV
+						inline_op = d.reg1 != 15;
+						break;
+					case 0b1100: // LSL
+					case 0b1101: // LSR
+						inline_op = d.reg1 != 15 && !d.set_status;
+						break;
+				}
+			}
+			else if (d.type == Type::EXTENDED)
+			{
+				if (d.op != 0b0000 && d.op < 0b0100) continue; // Unused, while WFI is left to the interpreter
+				if (d.op >= 0b1000) inline_op = (d.op & 0b0010) || d.reg1 != 15; // Writes, or reads not into the PC
+			}
+
+			if (!inline_op)
+			{
+				EmitInterpret(d, refund);
+				continue;
+			}
+
+			if (d.cond == 0xF) continue; // Never runs
+
+			byte* skip = nullptr;
+			if (d.cond != AL)
+			{
+				e.MovImm(X64_RAX, condition_masks[d.cond]);
+				e.Bt(X64_RAX, FLAGS);
+				skip = e.Jcc(X64_AE);
+			}
+
+			const int32_t reg1_offset = d.reg1 * sizeof(word);
+
+			if (d.type == Type::ARITHMETIC)
+			{
+				switch (d.op)
+				{
+					case 0b0000: // ADD
+					case 0b0001: // SUB
+						LoadReg(X64_RAX, d.reg2, d.address);
+						e.Movsxd(X64_RAX, X64_RAX);
+						LoadOperand3(X64_RCX, d);
+						e.Movsxd(X64_RCX, X64_RCX);
+						e.Alu(d.op == 0b0000 ? X64_ADD : X64_SUB, true, X64_RAX, X64_RCX);
+						if (d.negative) e.Neg(true, X64_RAX);
+						e.Store(REGS, reg1_offset, X64_RAX);
+						if (d.set_status) EmitArithmeticFlags(false);
+						break;
+
+					case 0b0110: // CMP
+						LoadReg(X64_RAX, d.reg1, d.address);
+						e.Movsxd(X64_RAX, X64_RAX);
+						LoadOperand2(X64_RCX, d);
+						e.Movsxd(X64_RCX, X64_RCX);
+						e.Alu(X64_SUB, true, X64_RAX, X64_RCX);
+						if (d.negative) e.Neg(true, X64_RAX);
+						EmitArithmeticFlags(false);
+						break;
+
+					case 0b0111: // CMN
+						LoadReg(X64_RAX, d.reg1, d.address); // Zero extended, unlike CMP
+						LoadOperand2(X64_RCX, d);
+						e.Movsxd(X64_RCX, X64_RCX);
+						e.Alu(X64_ADD, true, X64_RAX, X64_RCX);
+						if (d.negative) e.Neg(true, X64_RAX);
+						EmitArithmeticFlags(true);
+						break;
+
+					case 0b1000: // ORR
+					case 0b1001: // AND
+					case 0b1010: // XOR
+						LoadReg(X64_RAX, d.reg2, d.address);
+						LoadOperand3(X64_RCX, d);
+						e.Alu(d.op == 0b1000 ? X64_OR : d.op == 0b1001 ? X64_AND : X64_XOR, false, X64_RAX, X64_RCX);
+						if (d.negative) e.Not(X64_RAX);
+						e.Store(REGS, reg1_offset, X64_RAX);
+						if (d.set_status) EmitLogicFlags();
+						break;
+
+					case 0b1011: // TST
+						LoadReg(X64_RAX, d.reg1, d.address);
+						LoadOperand2(X64_RCX, d);
+						if (d.negative) e.Not(X64_RCX);
+						e.Alu(X64_AND, false, X64_RAX, X64_RCX);
+						EmitLogicFlags();
+						break;
+
+					case 0b1100: // LSL
+					case 0b1101: // LSR
+						LoadReg(X64_RAX, d.reg2, d.address);
+						LoadOperand3(X64_RCX, d);
+						if (d.op == 0b1100) e.ShlCL(X64_RAX);
+						else e.ShrCL(X64_RAX);
+						if (d.negative) e.Not(X64_RAX);
+						e.Store(REGS, reg1_offset, X64_RAX);
+						break;
+
+					case 0b1110: // MOV / MVN
+					case 0b1111: // INV
+						if (d.set_status) e.Load(X64_R8, REGS, reg1_offset);
+						LoadOperand2(X64_RAX, d);
+						if (d.op == 0b1111) e.Neg(false, X64_RAX);
+						if (d.negative) e.Not(X64_RAX);
+						e.Store(REGS, reg1_offset, X64_RAX);
+						if (d.set_status) EmitMoveFlags();
+						break;
+				}
+			}
+			else // RRW / RWW / RRB / RWB
+			{
+				const bool byte_access = (d.op & 0b0100) != 0;
+
+				if (d.op & 0b0010)
+				{
+					LoadReg(X64_R9, d.reg1, d.address);
+					EmitAddress(d);
+					EmitWrite(byte_access, next_PC, refund);
+				}
+				else
+				{
+					EmitAddress(d);
+					EmitRead(byte_access, refund);
+					e.Store(REGS, reg1_offset, X64_RAX);
+				}
+			}
+
+			if (skip != nullptr) e.Bind(skip);
+		}
+
+		// Blocks that don't end in a branch carry on to the next instruction
+		if (!ended) EmitLinkableExit(address + length * sizeof(word));
+
+		for (const PendingExit& exit : exits)
+		{
+			e.Bind(exit.site);
+
+			if (exit.set_PC) e.StoreImm(REGS, PC_offset, exit.PC);
+			if (exit.refund != 0) e.RR(true, { 0x81 }, X64_ADD, BUDGET), e.Dword(exit.refund);
+			e.Alu(X64_XOR, false, X64_RAX, X64_RAX);
+			X64Emitter::Bind(e.Jmp(), exit_code);
+		}
+
+		code_current = e.cur;
+
+		return &block;
+	}
+#else
+	void Little32JITCore::FlushBlocks() {}
+	void Little32JITCore::CollectRegions() {}
+	void Little32JITCore::EmitTrampolines() {}
+	Little32JITCore::Block* Little32JITCore::FindBlock(word) { return nullptr; }
+	Little32JITCore::Block* Little32JITCore::Compile(word) { return nullptr; }
+
+	Little32JITCore::Little32JITCore(Computer& computer) : Little32Core(computer) {}
+	Little32JITCore::~Little32JITCore() {}
+#endif
+}
\ No newline at end of file
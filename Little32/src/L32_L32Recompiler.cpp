@@ -0,0 +1,407 @@
+#include "L32_L32Recompiler.h"
+
+#include "L32_AOTModule.h"
+#include "L32_Computer.h"
+
+#include <cstdio>
+#include <deque>
+#include <set>
+#include <stdexcept>
+
+namespace Little32
+{
+	namespace
+	{
+		using Type = Little32Core::DecodedInstruction::Type;
+
+		constexpr word PC_index = 15;
+
+		std::string Hex(word value)
+		{
+			char str[16];
+			snprintf(str, sizeof(str), "0x%08Xu", value);
+			return str;
+		}
+
+		// Reads of PC see the address of the instruction
+		std::string Reg(byte reg, word address)
+		{
+			return reg == PC_index ? Hex(address) : "R[" + std::to_string(reg) + "]";
+		}
+
+		std::string Rotl(const std::string& value, byte shift)
+		{
+			return shift == 0 ? value : "std::rotl(" + value + ", " + std::to_string(shift) + ")";
+		}
+
+		const char* Condition(byte cond)
+		{
+			switch (cond)
+			{
+				case Little32Core::GT: return "(N == V) && !Z";
+				case Little32Core::GE: return "N == V";
+				case Little32Core::HI: return "C && !Z";
+				case Little32Core::CS: return "C";
+				case Little32Core::ZS: return "Z";
+				case Little32Core::NS: return "N";
+				case Little32Core::VS: return "V";
+				case Little32Core::VC: return "!V";
+				case Little32Core::NC: return "!N";
+				case Little32Core::ZC: return "!Z";
+				case Little32Core::CC: return "!C";
+				case Little32Core::LS: return "!C || Z";
+				case Little32Core::LT: return "N != V";
+				case Little32Core::LE: return "(N != V) || Z";
+				default: return "false";
+			}
+		}
+
+		// Leaves the block with PC set to target, having run count instructions
+		std::string Exit(const std::string& target, word count)
+		{
+			return "{ R[15] = " + target + "; c.flags = Pack(N, Z, C, V); return " + std::to_string(count) + "; }";
+		}
+
+		constexpr const char* prelude =
+R"(// Recompiled from Little32 ROM. Do not edit, recompile the ROM instead
+
+#include "L32_AOTModule.h"
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+using namespace Little32;
+
+namespace
+{
+	constexpr word Pack(bool N, bool Z, bool C, bool V)
+	{
+		return (N << 3) | (Z << 2) | (C << 1) | (word)V;
+	}
+
+	constexpr void Unpack(word flags, bool& N, bool& Z, bool& C, bool& V)
+	{
+		N = (flags & 0b1000) != 0;
+		Z = (flags & 0b0100) != 0;
+		C = (flags & 0b0010) != 0;
+		V = (flags & 0b0001) != 0;
+	}
+)";
+	}
+
+	bool Little32Recompiler::InROM(word address) const
+	{
+		return rom_size >= sizeof(word) && address % sizeof(word) == 0 && address - rom_start <= rom_size - sizeof(word);
+	}
+
+	void Little32Recompiler::FindBlocks(Computer& computer)
+	{
+		blocks.clear();
+
+		std::set<word> leaders;
+		std::deque<word> pending;
+
+		const auto AddLeader = [&](word address)
+		{
+			if (InROM(address) && leaders.insert(address).second) pending.push_back(address);
+		};
+
+		AddLeader(rom_start);
+		for (word address : entry_points) AddLeader(address);
+
+		// Code reached indirectly, such as interrupt handlers, has its address stored in ROM or moved into a register
+		for (word address = rom_start; InROM(address); address += sizeof(word))
+		{
+			const word value = computer.Read(address);
+			const Little32Core::DecodedInstruction d = Little32Core::Decode(value);
+
+			AddLeader(value);
+			if (d.type == Type::ARITHMETIC && d.op == 0b1110 && d.immediate) AddLeader(d.imm12 ^ (d.negative ? ~(word)0 : 0));
+		}
+
+		// Follow the code from every leader, to find the targets of branches and the instructions after calls
+		while (!pending.empty())
+		{
+			word address = pending.front();
+			pending.pop_front();
+
+			for (word length = 0; InROM(address); address += sizeof(word))
+			{
+				if (length++ == max_block_length)
+				{
+					AddLeader(address);
+					break;
+				}
+
+				const Little32Core::DecodedInstruction d = Little32Core::Decode(computer.Read(address));
+
+				if (d.type != Type::BRANCH) continue;
+
+				const bool indirect = d.negative && d.offset == 0; // RET or RFE
+				if (!indirect) AddLeader(address + d.offset);
+				if (d.cond != Little32Core::AL || d.link || indirect) AddLeader(address + sizeof(word));
+				break;
+			}
+		}
+
+		// Split the code at every leader
+		for (auto it = leaders.begin(); it != leaders.end(); it++)
+		{
+			const auto next = std::next(it);
+
+			Block& block = blocks[*it];
+			block.address = *it;
+
+			for (word address = *it; InROM(address) && block.code.size() < max_block_length; address += sizeof(word))
+			{
+				if (next != leaders.end() && address == *next) break;
+
+				const word instruction = computer.Read(address);
+				Little32Core::DecodedInstruction& d = block.instructions.emplace_back(Little32Core::Decode(instruction));
+				d.address = address;
+				d.valid = true;
+				block.code.push_back(instruction);
+
+				if (d.type == Type::BRANCH) break;
+			}
+		}
+	}
+
+	std::string Little32Recompiler::Translate(const Little32Core::DecodedInstruction& d, word count, bool& ends_block)
+	{
+		const word address = d.address;
+		const std::string R1 = Reg(d.reg1, address);
+		const std::string R2 = Reg(d.reg2, address);
+		const std::string R3 = Reg(d.reg3, address);
+
+		// Flexible operands: a constant if immediate, otherwise a register put through the barrel shift
+		const std::string val2 = d.immediate ? Hex(d.imm12) : Rotl(R2, d.shift);
+		const std::string val3 = d.immediate ? Hex(d.imm8) : Rotl(R3, d.shift);
+
+		const std::string inv = d.negative ? " * -1" : "";          // Negates 64 bit results
+		const std::string invw = d.negative ? " * 0xFFFFFFFFu" : ""; // Negates words
+		const std::string neg = d.negative ? " ^ 0xFFFFFFFFu" : "";  // Inverts words
+
+		// Hands the instruction to the interpreter, and leaves the block if it jumped
+		const std::string interpret =
+			"R[15] = " + Hex(address) + "; c.flags = Pack(N, Z, C, V); c.interpret(c); Unpack(c.flags, N, Z, C, V); " +
+			"if (R[15] != " + Hex(address + sizeof(word)) + ") return " + std::to_string(count) + ";";
+
+		ends_block = false;
+
+		std::string code;
+
+		switch (d.type)
+		{
+			case Type::ARITHMETIC:
+			{
+				const bool writes_reg1 = d.op != 0b0110 && d.op != 0b0111 && d.op != 0b1011;
+				if (writes_reg1 && d.reg1 == PC_index) return interpret;
+
+				const std::string result_flags = "N = (int32_t)" + R1 + " < 0; Z = " + R1 + " == 0; ";
+
+				switch (d.op)
+				{
+					case 0b0000: // ADD
+					case 0b0001: // SUB
+					case 0b0010: // ADC
+					case 0b0011: // SBB
+					{
+						const char* const sign = d.op & 1 ? " - " : " + ";
+						const std::string carry = d.op & 0b10 ? " + (int64_t)C * (1 - 2 * (int64_t)(N != V))" : "";
+
+						code = "const int64_t l = ((int64_t)(int32_t)" + R2 + sign + "(int64_t)(int32_t)" + val3 + carry + ")" + inv + "; " + R1 + " = (word)l;";
+						if (d.set_status) code += " " + result_flags + "C = (int32_t)" + R1 + " != l; V = (l < 0) != ((int32_t)" + R1 + " < 0);";
+						break;
+					}
+					// Shifts of 32 or more are masked like x86 does, as the interpreter inherits that from its host
+					case 0b0100: // ASL
+						code = "const word s = " + val3 + " & 31; " + R1 + " = (" + R2 + " << s)" + invw + ";";
+						if (d.set_status) code += " " + result_flags + "C = " + R2 + " != ((" + R1 + invw + ") >> s); V = ((int32_t)" + R2 + " < 0) != ((int32_t)" + R1 + " < 0);";
+						break;
+					case 0b0101: // ASR
+						code = "const word s = " + val3 + " & 31; " + R1 + " = ((" + R2 + " >> s) | ~(0xFFFFFFFFu >> s))" + invw + ";";
+						if (d.set_status) code += " " + result_flags + "C = " + R2 + " != ((" + R1 + invw + ") << s); V = ((int32_t)" + R2 + " < 0) != ((int32_t)" + R1 + " < 0);";
+						break;
+					case 0b0110: // CMP
+						code = "const int64_t l = ((int64_t)(int32_t)" + R1 + " - (int64_t)(int32_t)" + val2 + ")" + inv + "; const int32_t v = (int32_t)l; ";
+						code += "N = v < 0; Z = v == 0; C = v != l; V = (l < 0) != (v < 0);";
+						break;
+					case 0b0111: // CMN
+						code = "const int64_t l = ((int64_t)" + R1 + " + (int64_t)(int32_t)" + val2 + ")" + inv + "; const int32_t v = (int32_t)l; ";
+						code += "N = v < 0; Z = v == 0; C = ((l >> 32) & 1) != 0; V = (l < 0) != (v < 0);";
+						break;
+					case 0b1000: // ORR
+					case 0b1001: // AND
+					case 0b1010: // XOR
+					{
+						const char* const op = d.op == 0b1000 ? " | " : d.op == 0b1001 ? " & " : " ^ ";
+
+						code = R1 + " = (" + R2 + op + val3 + ")" + neg + ";";
+						if (d.set_status) code += " " + result_flags + "C = V = false;";
+						break;
+					}
+					case 0b1011: // TST
+						code = "const int32_t v = " + R1 + " & (" + val2 + neg + "); N = v < 0; Z = v == 0; C = V = false;";
+						break;
+					case 0b1100: // LSL
+						code = "const word s = " + val3 + " & 31; " + R1 + " = (" + R2 + " << s)" + neg + ";";
+						if (d.set_status) code += " " + result_flags + "C = " + R2 + " != ((" + R1 + neg + ") >> s); V = ((int32_t)" + R1 + " < 0) != ((int32_t)" + R2 + " < 0);";
+						break;
+					case 0b1101: // LSR
+						code = "const word s = " + val3 + " & 31; " + R1 + " = (" + R2 + " >> s)" + neg + ";";
+						if (d.set_status) code += " " + result_flags + "C = " + R2 + " != ((" + R1 + neg + ") << s); V = ((int32_t)" + R1 + " < 0) != ((int32_t)" + R2 + " < 0);";
+						break;
+					case 0b1110: // MOV
+					case 0b1111: // INV
+						code = "const word v = " + val2 + "; ";
+						if (d.set_status) code += "const int32_t o = (int32_t)" + R1 + "; ";
+						code += R1 + " = " + (d.op == 0b1110 ? "v" : "(~v + 1)") + neg + ";";
+						// MOV and INV compare an unsigned register with 0, so never set N
+						if (d.set_status) code += " N = false; Z = " + R1 + " == 0; C = false; V = (o < 0) != ((int32_t)" + R1 + " < 0);";
+						break;
+				}
+				break;
+			}
+			case Type::BRANCH:
+			{
+				if (d.negative && d.offset == 0)
+				{
+					if (!d.link) return interpret; // RFE
+
+					code = "R[15] = R[14]; c.flags = Pack(N, Z, C, V); return " + std::to_string(count) + ";"; // RET
+				}
+				else
+				{
+					if (d.link) code = "R[14] = " + Hex(address + sizeof(word)) + "; ";
+					code += Exit(Hex(address + d.offset), count);
+				}
+
+				ends_block = d.cond == Little32Core::AL;
+				break;
+			}
+			case Type::EXTENDED:
+			{
+				if (d.op >= 0b1000)
+				{
+					const bool writes_reg1 = d.op == 0b1000 || d.op == 0b1001 || d.op == 0b1100 || d.op == 0b1101;
+					if (writes_reg1 && d.reg1 == PC_index) return interpret;
+
+					// Odd opcodes use an immediate offset
+					const std::string offset = (d.op & 1) ? Hex(d.imm8 * (d.negative ? -1 : 1)) : Rotl(R3, d.shift) + invw;
+
+					code = "const word a = " + R2 + " + " + offset + "; ";
+
+					switch (d.op)
+					{
+						case 0b1000: case 0b1001: code += R1 + " = c.read(c, a);"; break;          // RRW
+						case 0b1010: case 0b1011: code += "c.write(c, a, " + R1 + ");"; break;      // RWW
+						case 0b1100: case 0b1101: code += R1 + " = c.read_byte(c, a);"; break;     // RRB
+						case 0b1110: case 0b1111: code += "c.write_byte(c, a, " + R1 + ");"; break; // RWB
+					}
+				}
+				else if (d.op == 0b0100) // SRR
+				{
+					if (d.reg1 == PC_index || (d.reglist & (1 << PC_index))) return interpret;
+
+					for (word i = 16; i--;)
+					{
+						if (d.reglist & (1 << i)) code += R1 + " += 4; R[" + std::to_string(i) + "] = c.read(c, " + R1 + " - 4)" + invw + "; ";
+					}
+				}
+				else if (d.op == 0b0101) // SWR
+				{
+					if (d.reg1 == PC_index) return interpret;
+
+					for (word i = 0; i < 16; i++)
+					{
+						if (d.reglist & (1 << i)) code += "{ const word v = " + Reg(i, address) + invw + "; " + R1 + " -= 4; c.write(c, " + R1 + ", v); } ";
+					}
+				}
+				else if (d.op == 0b0110) // MVM
+				{
+					if (d.reglist & (1 << PC_index)) return interpret;
+
+					code = "const word v = " + R1 + invw + "; ";
+					for (word i = 0; i < 16; i++)
+					{
+						if (d.reglist & (1 << i)) code += "R[" + std::to_string(i) + "] = v; ";
+					}
+				}
+				else if (d.op == 0b0111) // SWP
+				{
+					if (d.reg1 == PC_index || d.reg2 == PC_index) return interpret;
+
+					code = R2 + " = " + Rotl(R2, d.shift) + invw + "; std::swap(" + R1 + ", " + R2 + ");";
+				}
+				else if (d.op == 0b0000) return interpret; // WFI
+				// 0b0001 - 0b0011: Do nothing
+				break;
+			}
+			case Type::FLOAT:
+				return interpret;
+			case Type::NOP:
+				break;
+		}
+
+		if (code.empty()) return "";
+		if (d.cond == Little32Core::AL) return "{ " + code + " }";
+		return "if (" + std::string(Condition(d.cond)) + ") { " + code + " }";
+	}
+
+	void Little32Recompiler::Recompile(Computer& computer, std::ostream& out)
+	{
+		if (!InROM(rom_start)) throw std::runtime_error("No ROM to recompile");
+
+		FindBlocks(computer);
+
+		// Only used for disassembly, which doesn't depend on its state
+		const Little32Core disassembler(computer);
+
+		out << prelude;
+
+		for (const auto& [address, block] : blocks)
+		{
+			out << "\n\tword Block_" << Hex(address).substr(2, 8) << "(AOTContext& c)\n\t{\n";
+			out << "\t\tword* const R = c.registers;\n";
+			out << "\t\tbool N, Z, C, V;\n";
+			out << "\t\tUnpack(c.flags, N, Z, C, V);\n\n";
+
+			bool ended = false;
+
+			for (word i = 0; i < block.instructions.size(); i++)
+			{
+				const Little32Core::DecodedInstruction& d = block.instructions[i];
+
+				out << "\t\t// " << Hex(d.address).substr(2, 8) << ": " << disassembler.Disassemble(block.code[i]) << "\n";
+
+				const std::string code = Translate(d, i + 1, ended);
+				if (!code.empty()) out << "\t\t" << code << "\n";
+			}
+
+			if (!ended)
+			{
+				const word next = address + (word)block.instructions.size() * sizeof(word);
+				out << "\n\t\tR[15] = " << Hex(next) << ";\n";
+				out << "\t\tc.flags = Pack(N, Z, C, V);\n";
+				out << "\t\treturn " << block.instructions.size() << ";\n";
+			}
+
+			out << "\t}\n";
+		}
+
+		const word checksum = AOTChecksum([&](word i) { return computer.Read(rom_start + i * sizeof(word)); }, rom_size / sizeof(word));
+
+		out << "\n\tconstexpr AOTBlock blocks[]\n\t{\n";
+		for (const auto& [address, block] : blocks)
+		{
+			out << "\t\t{ " << Hex(address) << ", " << block.instructions.size() << ", &Block_" << Hex(address).substr(2, 8) << " },\n";
+		}
+		out << "\t};\n\n";
+
+		out << "\tconstexpr AOTModule module { " << aot_module_version << ", " << Hex(rom_start) << ", " << Hex(rom_size) << ", " << Hex(checksum) << ", " << blocks.size() << ", blocks };\n";
+		out << "}\n\n";
+		out << "L32_AOT_EXPORT const AOTModule* Little32Module() { return &module; }\n";
+	}
+}
\ No newline at end of file
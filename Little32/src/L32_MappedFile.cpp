@@ -0,0 +1,138 @@
+#include "L32_MappedFile.h"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+// We don't want to inherit the min and max macros from windows
+#ifndef NOMINMAX
+#define NOMINMAX
+#include <Windows.h>
+#undef NOMINMAX
+#else
+#include <Windows.h>
+#endif // !NOMINMAX
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Little32
+{
+	MappedFile::MappedFile(const std::filesystem::path& path, size_t size, Mode mode) :
+		size(size),
+		mode(mode)
+	{
+		if (size == 0) throw std::runtime_error("Can't map an empty range of '" + path.string() + "'");
+
+		const bool shared = mode == Mode::SHARED;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW
+		(
+			path.c_str(),
+			shared ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE,
+			nullptr,
+			shared ? OPEN_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr
+		);
+		if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Could not open '" + path.string() + "'");
+
+		LARGE_INTEGER file_size;
+		if (!shared && (!GetFileSizeEx(file, &file_size) || (uint64_t)file_size.QuadPart < size))
+		{
+			CloseHandle(file);
+			throw std::runtime_error("'" + path.string() + "' is smaller than the " + std::to_string(size) + " bytes mapped from it");
+		}
+
+		// A shared mapping larger than the file extends it
+		HANDLE mapping = CreateFileMappingW(file, nullptr, shared ? PAGE_READWRITE : PAGE_WRITECOPY, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			throw std::runtime_error("Could not map '" + path.string() + "'");
+		}
+
+		void* view = MapViewOfFile(mapping, shared ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, size);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::runtime_error("Could not map '" + path.string() + "'");
+		}
+
+		file_handle = file;
+		mapping_handle = mapping;
+		data = static_cast<word*>(view);
+#else
+		const int fd = open(path.c_str(), shared ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+		if (fd < 0) throw std::runtime_error("Could not open '" + path.string() + "'");
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			close(fd);
+			throw std::runtime_error("Could not open '" + path.string() + "'");
+		}
+
+		if ((uint64_t)st.st_size < size)
+		{
+			// Reading past the end of a file faults, so a shared file is extended to fit instead
+			if (!shared || ftruncate(fd, (off_t)size) != 0)
+			{
+				close(fd);
+				throw std::runtime_error("'" + path.string() + "' is smaller than the " + std::to_string(size) + " bytes mapped from it");
+			}
+		}
+
+		// Private mappings are copy on write, even though the file was only opened for reading
+		void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+
+		// The mapping keeps the file open by itself
+		close(fd);
+
+		if (view == MAP_FAILED) throw std::runtime_error("Could not map '" + path.string() + "'");
+
+		data = static_cast<word*>(view);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		// Whatever was written last should be in the file by the time it's closed
+		Flush(true);
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(static_cast<HANDLE>(mapping_handle));
+		CloseHandle(static_cast<HANDLE>(file_handle));
+#else
+		munmap(data, size);
+#endif
+	}
+
+	void MappedFile::Flush(bool wait)
+	{
+		if (mode != Mode::SHARED) return;
+
+#ifdef _WIN32
+		// Only starts writing the pages, the file's buffers are what wait for them
+		FlushViewOfFile(data, 0);
+		if (wait) FlushFileBuffers(static_cast<HANDLE>(file_handle));
+#else
+		msync(data, size, wait ? MS_SYNC : MS_ASYNC);
+#endif
+	}
+
+	std::shared_ptr<word[]> MappedFile::Map(const std::filesystem::path& path, size_t size, Mode mode)
+	{
+		const std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path, size, mode);
+
+		// Shares ownership with the file, so it's unmapped along with the last device using it
+		return std::shared_ptr<word[]>(file, file->GetData());
+	}
+}
\ No newline at end of file
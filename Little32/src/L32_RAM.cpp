@@ -3,70 +3,64 @@
 #include "L32_BigInt.h"
 #include "L32_Computer.h"
 #include "L32_IDeviceSettings.h"
+#include "L32_ImageCache.h"
+#include "L32_MappedFile.h"
+#include "L32_SparseRAM.h"
 #include "L32_String.h"
 #include "L32_VarValue.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace Little32
 {
-	void RAM::_WriteWordUnsafe(word address, word value)
-	{
-		if (address % sizeof(word) == 0)
-		{
-			memory[address / sizeof(word)] = value;
-		}
-		else
-		{
-			const word x = (address % sizeof(word)) * 8;
-
-			memory[(address / sizeof(word)) + 0] &= (1 << x) - 1;
-			memory[(address / sizeof(word)) + 0] |= value << x;
-
-			memory[(address / sizeof(word)) + 1] &= (1 >> (32 - x)) - 1;
-			memory[(address / sizeof(word)) + 1] |= value >> (32 - x);
-		}
-	}
-
-	void RAM::_WriteByteUnsafe(word address, byte value)
-	{
-		word x = (address % sizeof(word)) * 8;
-
-		value ^= memory[address / sizeof(word)] >> x;
-		memory[address / sizeof(word)] ^= value << x;
-	}
-
-	word RAM::_ReadWordUnsafe(word address) { return memory[address / sizeof(word)]; }
-
-	byte RAM::_ReadByteUnsafe(word address) { return memory[address / sizeof(word)] >> ((address % sizeof(word)) * 8); }
-
 	RAM::RAM(word address, word size, std::shared_ptr<word[]>& memory) :
 		address_start(address),
 		address_size(size * sizeof(word)),
 		default_memory(memory),
-		memory(new word[size](0))
+		dirty_pages(new byte[((uint64_t)size * sizeof(word) + dirty_page_size - 1) >> dirty_page_bits](0))
 	{
-		if (!default_memory) return;
-		memcpy(this->memory.get(), default_memory.get(), address_size);
+		if (!default_memory)
+		{
+			this->memory = std::shared_ptr<word[]>(new word[size](0));
+			return;
+		}
+
+		// Only the pages that get written are copied, the rest are shared with every RAM that started with the same memory
+		this->memory = ImageCache::Map(default_memory.get(), size);
 	}
 
 	RAM::RAM(word address, word size, char default_byte) :
 		address_start(address),
 		address_size(size * sizeof(word)),
-		memory(new word[size](0)) {
+		default_byte(default_byte),
+		memory(new word[size](0)),
+		dirty_pages(new byte[((uint64_t)size * sizeof(word) + dirty_page_size - 1) >> dirty_page_bits](0)) {
 		memset(memory.get(), default_byte, size * sizeof(word));
 	}
 
-	void RAM::Write(word address, word value)
+	RAM::RAM(word address, word size, const std::shared_ptr<MappedFile>& backing_file) :
+		address_start(address),
+		address_size(size * sizeof(word)),
+		memory(backing_file, backing_file->GetData()),
+		dirty_pages(new byte[((uint64_t)size * sizeof(word) + dirty_page_size - 1) >> dirty_page_bits](0)),
+		backing_file(backing_file) {}
+
+	RAM::~RAM()
 	{
-		if (address + 3 >= address_size) return;
+		if (flush_interval == nullptr) return;
 
-		return address % sizeof(word) ? _WriteByteUnsafe(address, value) : _WriteWordUnsafe(address, value);
+		flush_computer->RemoveInterval(flush_interval);
 	}
 
-	void RAM::WriteByte(word address, byte value)
+	void RAM::_MarkDirtyRange(word address, word size)
 	{
-		if (address >= address_size) return;
+		if (size == 0) return;
 
-		return _WriteByteUnsafe(address, value);
+		for (word p = address >> dirty_page_bits; p <= (address + size - 1) >> dirty_page_bits; p++)
+		{
+			_MarkDirty(p << dirty_page_bits);
+		}
 	}
 
 	void RAM::WriteForced(word address, word value)
@@ -79,27 +73,70 @@ namespace Little32
 		WriteByte(address, value);
 	}
 
-	word RAM::Read(word address)
+	void RAM::ReadBlock(word address, word* values, word count)
 	{
-		if (address >= address_size) return 0;
+		// Anything unaligned or out of range is left to Read, one word at a time
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::ReadBlock(address, values, count);
+		}
 
-		return address % sizeof(word) ? _ReadByteUnsafe(address) : _ReadWordUnsafe(address);
+		memcpy(values, memory.get() + address / sizeof(word), count * sizeof(word));
 	}
 
-	byte RAM::ReadByte(word address)
+	void RAM::WriteBlock(word address, const word* values, word count)
 	{
-		if (address >= address_size) return 0;
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::WriteBlock(address, values, count);
+		}
+
+		_MarkDirtyRange(address, count * sizeof(word));
+		memcpy(memory.get() + address / sizeof(word), values, count * sizeof(word));
+	}
 
-		return _ReadByteUnsafe(address);
+	void RAM::WriteBlockForced(word address, const word* values, word count)
+	{
+		WriteBlock(address, values, count);
+	}
+
+	void RAM::Fill(word address, word value, word count)
+	{
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::Fill(address, value, count);
+		}
+
+		_MarkDirtyRange(address, count * sizeof(word));
+		std::fill_n(memory.get() + address / sizeof(word), count, value);
+	}
+
+	void RAM::FillForced(word address, word value, word count)
+	{
+		Fill(address, value, count);
 	}
 
 	void RAM::Reset()
 	{
-		if (default_memory) memcpy(memory.get(), default_memory.get(), address_size);
-		else memset(memory.get(), 0, address_size);
+		// The file is kept as it is, like memory with a battery
+		if (backing_file) return;
+
+		// Untouched pages still hold what they started with
+		for (const word p : dirty_list)
+		{
+			const word start = p << dirty_page_bits;
+			const word size = std::min(dirty_page_size, address_size - start);
+
+			if (default_memory) memcpy(memory.get() + start / sizeof(word), default_memory.get() + start / sizeof(word), size);
+			else memset(reinterpret_cast<byte*>(memory.get()) + start, default_byte, size);
+
+			dirty_pages[p] = 0;
+		}
+
+		dirty_list.clear();
 	};
 
-	void RAMFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path) const
+	void RAMFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path cur_path) const
 	{
 		assert( settings.Contains("size_words"));
 		assert( settings["size_words"].GetType() == INTEGER_VAR);
@@ -136,11 +173,42 @@ namespace Little32
 			}
 		}
 
-		RAM* device;
+		bool sparse = false;
+		if (settings.Contains("sparse"))
+		{
+			assert(settings["sparse"].GetType() == BOOLEAN_VAR);
+			sparse = settings["sparse"].GetBooleanValue();
+		}
+
+		IMappedDevice* device;
+
+		if (settings.Contains("backing_file"))
+		{
+			assert(settings["backing_file"].GetType() == STRING_VAR);
+
+			const std::filesystem::path path = (cur_path.parent_path() / settings["backing_file"].GetStringValue()).lexically_normal();
+
+			// Roughly every second at the default clock speed
+			size_t flush_interval = 60000;
+			if (settings.Contains("flush_interval"))
+			{
+				assert(settings["flush_interval"].GetType() == INTEGER_VAR);
+				flush_interval = static_cast<size_t>(settings["flush_interval"].GetIntegerValue().bits[0]);
+			}
+
+			const std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path, (size_t)words * sizeof(word), MappedFile::Mode::SHARED);
+			RAM* ram = new RAM(start_address, words, file);
 
-		if (!settings.Contains("RAM_data"))
+			// Only starts writing back what changed, so the computer never waits on the disk
+			ram->flush_computer = &computer;
+			ram->flush_interval = computer.AddInterval(flush_interval, [file](Computer&) { file->Flush(); });
+
+			device = ram;
+		}
+		else if (!settings.Contains("RAM_data"))
 		{
-			device = new RAM(start_address, words, default_byte);
+			if (sparse) device = new SparseRAM(start_address, words, default_byte);
+			else device = new RAM(start_address, words, default_byte);
 		}
 		else
 		{
@@ -148,12 +216,14 @@ namespace Little32
 			assert(settings["RAM_data"].GetStringValue().size() <= words * sizeof(word));
 			assert(settings["RAM_data"].GetStringValue().size() / sizeof(word) <= ~word(0) / sizeof(word));
 
-			word* const arr = new word[words];
-			std::shared_ptr<word[]> memory(arr);
+			// Sparse RAM only keeps the words the data covers, and leaves the rest unallocated
+			const word data_words = sparse ? static_cast<word>((settings["RAM_data"].GetStringValue().size() + sizeof(word) - 1) / sizeof(word)) : words;
+
+			std::vector<word> arr(data_words);
 
 			size_t i = 0;
 
-			memset(arr, default_byte, words * sizeof(word));
+			memset(arr.data(), default_byte, data_words * sizeof(word));
 
 			for (const char& c : settings["RAM_data"].GetStringValue())
 			{
@@ -161,7 +231,11 @@ namespace Little32
 				++i;
 			}
 
-			device = new RAM(start_address, words, memory);
+			// Shared by every computer with the same RAM, as nothing ever writes to it
+			std::shared_ptr<word[]> memory = ImageCache::Map(arr.data(), data_words);
+
+			if (sparse) device = new SparseRAM(start_address, words, memory, data_words, default_byte);
+			else device = new RAM(start_address, words, memory);
 		}
 
 		start_address += words * sizeof(word);
@@ -195,6 +269,22 @@ namespace Little32
 				: 0;
 		}
 
+		if (settings.Contains("sparse"))
+		{
+			MatchType(settings["sparse"], BOOLEAN_VAR, "sparse");
+		}
+
+		if (settings.Contains("backing_file"))
+		{
+			MatchType(settings["backing_file"], STRING_VAR, "backing_file");
+
+			if (settings.Contains("RAM_data")) throw std::runtime_error("RAM can't have both 'backing_file' and 'RAM_data'");
+			if (settings.Contains("sparse") && settings["sparse"].GetBooleanValue()) throw std::runtime_error("RAM with a 'backing_file' can't be sparse");
+
+			if (settings.Contains("flush_interval")) MatchUIntRange<0x00000001, 0xFFFFFFFF>(settings["flush_interval"], "flush_interval");
+		}
+		else if (settings.Contains("flush_interval")) throw std::runtime_error("RAM has a 'flush_interval', but no 'backing_file'");
+
 		if (settings.Contains("RAM_data"))
 		{
 			MatchType(settings["RAM_data"], STRING_VAR, "RAM_data");
@@ -3,11 +3,38 @@
 #include "L32_BigInt.h"
 #include "L32_Computer.h"
 #include "L32_IDeviceSettings.h"
+#include "L32_ImageCache.h"
+#include "L32_MappedFile.h"
 #include "L32_String.h"
 #include "L32_VarValue.h"
 
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
 namespace Little32
 {
+	namespace
+	{
+		/// <summary> Finds an image relative to the config, or else relative to the program </summary>
+		std::filesystem::path FindImage(const std::filesystem::path& config_path, const std::string& file)
+		{
+			const auto relative_to_config = (config_path.parent_path() / file).lexically_normal();
+			if (std::filesystem::is_regular_file(relative_to_config)) return relative_to_config;
+
+			const auto relative_to_program = (std::filesystem::current_path() / file).lexically_normal();
+			if (std::filesystem::is_regular_file(relative_to_program)) return relative_to_program;
+
+			throw std::runtime_error("Could not open ROM file at '" + file + "'");
+		}
+
+		/// <summary> The number of words a ROM needs to hold all of a file </summary>
+		uint64_t ImageWords(const std::filesystem::path& file)
+		{
+			return (std::filesystem::file_size(file) + sizeof(word) - 1) / sizeof(word);
+		}
+	}
+
 	void ROM::_WriteByteUnsafe(word address, byte value)
 	{
 		const word x = (address % sizeof(word)) * 8;
@@ -33,9 +60,6 @@ namespace Little32
 		}
 	}
 
-	word ROM::_ReadWordUnsafe(word address) { return memory[address / sizeof(word)] ; }
-	byte ROM::_ReadByteUnsafe(word address) { return memory[address / sizeof(word)] >> ((address % sizeof(word)) * 8); }
-
 	ROM::ROM(word address, word size, std::shared_ptr<word[]>& memory) :
 		address_start(address),
 		address_size(size * sizeof(word)),
@@ -52,48 +76,96 @@ namespace Little32
 		memset(memory.get(), default_byte, size * sizeof(word));
 	}
 
-	word ROM::Read(word address)
+	void ROM::WriteForced(word address, word value)
 	{
-		if (address >= address_size) return 0;
+		if (address + 3 >= address_size) return;
 
-		return address % sizeof(word) ? _ReadByteUnsafe(address) : _ReadWordUnsafe(address);
+		shared = false;
+		_WriteWordUnsafe(address, value);
 	}
 
-	byte ROM::ReadByte(word address)
+	void ROM::WriteByteForced(word address, byte value)
 	{
-		if (address >= address_size) return 0;
+		if (address >= address_size) return;
 
-		return _ReadByteUnsafe(address);
+		shared = false;
+		_WriteByteUnsafe(address, value);
 	}
 
-	void ROM::WriteForced(word address, word value)
+	void ROM::ReadBlock(word address, word* values, word count)
 	{
-		if (address + 3 >= address_size) return;
+		// Anything unaligned or out of range is left to Read, one word at a time
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::ReadBlock(address, values, count);
+		}
 
-		_WriteWordUnsafe(address, value);
+		memcpy(values, memory.get() + address / sizeof(word), count * sizeof(word));
 	}
 
-	void ROM::WriteByteForced(word address, byte value)
+	void ROM::WriteBlockForced(word address, const word* values, word count)
 	{
-		if (address >= address_size) return;
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::WriteBlockForced(address, values, count);
+		}
 
-		_WriteByteUnsafe(address, value);
+		shared = false;
+		memcpy(memory.get() + address / sizeof(word), values, count * sizeof(word));
+	}
+
+	void ROM::FillForced(word address, word value, word count)
+	{
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::FillForced(address, value, count);
+		}
+
+		shared = false;
+		std::fill_n(memory.get() + address / sizeof(word), count, value);
+	}
+
+	void ROM::Share()
+	{
+		// Moving a mapped file into the cache would copy all of it, and lose the pages it shares with other processes
+		if (shared) return;
+
+		memory = ImageCache::Map(memory.get(), address_size / sizeof(word));
+		shared = true;
 	}
 
-	void ROMFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path) const
+	void ROMFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path cur_path) const
 	{
-		assert(settings.Contains("size_words"));
-		assert(settings["size_words"].GetType() == INTEGER_VAR);
-		assert(!settings["size_words"].GetIntegerValue().negative);
-		assert(settings["size_words"].GetIntegerValue().bits.size() == 1);
-		assert(settings["size_words"].GetIntegerValue().bits[0] <= 0xFFFFFFFF);
-
-		const uint32_t words = static_cast<uint32_t>
-			(
-				settings["size_words"]
-				.GetIntegerValue()
-				.bits[0]
-				);
+		std::filesystem::path file;
+
+		if (settings.Contains("ROM_file"))
+		{
+			assert(settings["ROM_file"].GetType() == STRING_VAR);
+			file = FindImage(cur_path, settings["ROM_file"].GetStringValue());
+		}
+
+		uint32_t words;
+
+		if (settings.Contains("size_words"))
+		{
+			assert(settings["size_words"].GetType() == INTEGER_VAR);
+			assert(!settings["size_words"].GetIntegerValue().negative);
+			assert(settings["size_words"].GetIntegerValue().bits.size() == 1);
+			assert(settings["size_words"].GetIntegerValue().bits[0] <= 0xFFFFFFFF);
+
+			words = static_cast<uint32_t>
+				(
+					settings["size_words"]
+					.GetIntegerValue()
+					.bits[0]
+					);
+		}
+		else
+		{
+			// Without a size, the ROM is as big as its file
+			assert(!file.empty());
+			words = static_cast<uint32_t>(ImageWords(file));
+		}
 
 		uint8_t default_byte = 0;
 		if (settings.Contains("default_byte"))
@@ -119,30 +191,53 @@ namespace Little32
 
 		ROM* device;
 
-		if (!settings.Contains("ROM_data"))
+		if (!file.empty())
 		{
-			device = new ROM(start_address, words, default_byte);
+			const uint64_t file_size = std::filesystem::file_size(file);
+			const bool mapped = words <= ImageWords(file);
+			std::shared_ptr<word[]> memory;
+
+			if (mapped)
+			{
+				// Mapped straight from the file, so nothing is read until it's used. The last page reads as 0 past the end of the file
+				memory = MappedFile::Map(file, std::min<uint64_t>(file_size, words * sizeof(word)), MappedFile::Mode::COPY_ON_WRITE);
+			}
+			else
+			{
+				// Memory past the end of a file can't be mapped, so a ROM bigger than its file is read into memory instead
+				memory = std::shared_ptr<word[]>(new word[words]);
+				memset(memory.get(), default_byte, words * sizeof(word));
+
+				std::ifstream stream(file, std::ios::binary);
+				stream.read(reinterpret_cast<char*>(memory.get()), file_size);
+			}
+
+			device = new ROM(start_address, words, memory);
+			device->shared = mapped;
 		}
 		else
 		{
-			assert(settings["ROM_data"].GetType() == STRING_VAR);
-			assert(settings["ROM_data"].GetStringValue().size() <= words * sizeof(word));
-			assert(settings["ROM_data"].GetStringValue().size() / sizeof(word) <= ~word(0) / sizeof(word));
+			std::vector<word> arr(words, 0x01010101u * default_byte);
 
-			word* const arr = new word[words];
-			std::shared_ptr<word[]> memory(arr);
-
-			size_t i = 0;
+			if (settings.Contains("ROM_data"))
+			{
+				assert(settings["ROM_data"].GetType() == STRING_VAR);
+				assert(settings["ROM_data"].GetStringValue().size() <= words * sizeof(word));
+				assert(settings["ROM_data"].GetStringValue().size() / sizeof(word) <= ~word(0) / sizeof(word));
 
-			memset(arr, default_byte, words * sizeof(word));
+				size_t i = 0;
 
-			for (const char& c : settings["ROM_data"].GetStringValue())
-			{
-				arr[i / sizeof(word)] |= c * (i % sizeof(word)) * 8;
-				++i;
+				for (const char& c : settings["ROM_data"].GetStringValue())
+				{
+					arr[i / sizeof(word)] |= c * (i % sizeof(word)) * 8;
+					++i;
+				}
 			}
 
+			// Every computer with the same ROM shares its memory, until something is written to it
+			std::shared_ptr<word[]> memory = ImageCache::Map(arr.data(), words);
 			device = new ROM(start_address, words, memory);
+			device->shared = true;
 		}
 
 		assert(settings.named_labels.empty());
@@ -154,16 +249,36 @@ namespace Little32
 
 	void ROMFactory::VerifySettings(const IDeviceSettings& settings, std::filesystem::path cur_path) const
 	{
-		if (!settings.Contains("size_words")) throw std::exception("ROM must have a size");
+		uint64_t file_words = 0;
+
+		if (settings.Contains("ROM_file"))
+		{
+			MatchType(settings["ROM_file"], STRING_VAR, "ROM_file");
 
-		MatchUIntRange<0x00000001, 0xFFFFFFFF>(settings["size_words"], "size_words");
+			if (settings.Contains("ROM_data")) throw std::runtime_error("ROM can't have both 'ROM_file' and 'ROM_data'");
 
-		const uint32_t words = static_cast<uint32_t>
-			(
-				settings["size_words"]
-				.GetIntegerValue()
-				.bits[0]
-				);
+			file_words = ImageWords(FindImage(cur_path, settings["ROM_file"].GetStringValue()));
+
+			if (file_words == 0) throw std::runtime_error("ROM file is empty");
+			if (file_words > 0xFFFFFFFF) throw std::runtime_error("ROM file is larger than addressable range");
+		}
+		else if (!settings.Contains("size_words")) throw std::exception("ROM must have a size");
+
+		uint32_t words = static_cast<uint32_t>(file_words);
+
+		if (settings.Contains("size_words"))
+		{
+			MatchUIntRange<0x00000001, 0xFFFFFFFF>(settings["size_words"], "size_words");
+
+			words = static_cast<uint32_t>
+				(
+					settings["size_words"]
+					.GetIntegerValue()
+					.bits[0]
+					);
+
+			if (file_words > words) throw std::runtime_error("ROM file is too large for the size of ROM");
+		}
 
 		uint8_t default_byte = 0;
 		if (settings.Contains("default_byte"))
@@ -0,0 +1,179 @@
+#include "L32_SparseRAM.h"
+
+#include <cstring>
+
+namespace Little32
+{
+	SparseRAM::SparseRAM(word address, word size, std::shared_ptr<word[]>& memory, word memory_words, char default_byte) :
+		SparseRAM(address, size, default_byte)
+	{
+		default_memory = memory;
+		default_memory_words = memory_words;
+
+		Reset();
+	}
+
+	SparseRAM::SparseRAM(word address, word size, char default_byte) :
+		address_start(address),
+		address_size(size * sizeof(word)),
+		default_byte(default_byte),
+		default_word(0x01010101u * (byte)default_byte),
+		pages(((uint64_t)size * sizeof(word) + page_size - 1) >> page_bits) {}
+
+	word* SparseRAM::_CommitPage(word address)
+	{
+		std::unique_ptr<word[]>& page = pages[address >> page_bits];
+
+		if (!page)
+		{
+			page.reset(new word[page_words]);
+			std::fill_n(page.get(), page_words, default_word);
+			committed_pages++;
+		}
+
+		return page.get();
+	}
+
+	void SparseRAM::_WriteByteUnsafe(word address, byte value)
+	{
+		word* page = _FindPage(address);
+
+		// Writing what's already there doesn't need a page
+		if (page == nullptr)
+		{
+			if (value == default_byte) return;
+			page = _CommitPage(address);
+		}
+
+		word& w = page[(address % page_size) / sizeof(word)];
+		const word x = (address % sizeof(word)) * 8;
+
+		value ^= w >> x;
+		w ^= value << x;
+	}
+
+	void SparseRAM::WriteForced(word address, word value)
+	{
+		Write(address, value);
+	}
+
+	void SparseRAM::WriteByteForced(word address, byte value)
+	{
+		WriteByte(address, value);
+	}
+
+	void SparseRAM::Write(word address, word value)
+	{
+		if (address + 3 >= address_size) return;
+
+		// Like RAM, an unaligned word only writes its lowest byte
+		if (address % sizeof(word)) return _WriteByteUnsafe(address, value);
+
+		word* page = _FindPage(address);
+
+		if (page == nullptr)
+		{
+			if (value == default_word) return;
+			page = _CommitPage(address);
+		}
+
+		page[(address % page_size) / sizeof(word)] = value;
+	}
+
+	void SparseRAM::WriteByte(word address, byte value)
+	{
+		if (address >= address_size) return;
+
+		_WriteByteUnsafe(address, value);
+	}
+
+	word SparseRAM::Read(word address)
+	{
+		if (address >= address_size) return 0;
+
+		return address % sizeof(word) ? _ReadByteUnsafe(address) : _ReadWordUnsafe(address);
+	}
+
+	byte SparseRAM::ReadByte(word address)
+	{
+		if (address >= address_size) return 0;
+
+		return _ReadByteUnsafe(address);
+	}
+
+	void SparseRAM::ReadBlock(word address, word* values, word count)
+	{
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::ReadBlock(address, values, count);
+		}
+
+		_ForEachPage(address, count, [&](word address, word i, word n)
+		{
+			const word* const page = _FindPage(address);
+
+			if (page == nullptr) std::fill_n(values + i, n, default_word);
+			else memcpy(values + i, page + (address % page_size) / sizeof(word), n * sizeof(word));
+		});
+	}
+
+	void SparseRAM::WriteBlock(word address, const word* values, word count)
+	{
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::WriteBlock(address, values, count);
+		}
+
+		_ForEachPage(address, count, [&](word address, word i, word n)
+		{
+			word* page = _FindPage(address);
+
+			if (page == nullptr)
+			{
+				if (std::all_of(values + i, values + i + n, [this](word v) { return v == default_word; })) return;
+				page = _CommitPage(address);
+			}
+
+			memcpy(page + (address % page_size) / sizeof(word), values + i, n * sizeof(word));
+		});
+	}
+
+	void SparseRAM::WriteBlockForced(word address, const word* values, word count)
+	{
+		WriteBlock(address, values, count);
+	}
+
+	void SparseRAM::Fill(word address, word value, word count)
+	{
+		if (address % sizeof(word) != 0 || count > address_size / sizeof(word) || address > address_size - count * sizeof(word))
+		{
+			return IMemoryMapped::Fill(address, value, count);
+		}
+
+		_ForEachPage(address, count, [&](word address, word, word n)
+		{
+			word* page = _FindPage(address);
+
+			if (page == nullptr)
+			{
+				if (value == default_word) return;
+				page = _CommitPage(address);
+			}
+
+			std::fill_n(page + (address % page_size) / sizeof(word), n, value);
+		});
+	}
+
+	void SparseRAM::FillForced(word address, word value, word count)
+	{
+		Fill(address, value, count);
+	}
+
+	void SparseRAM::Reset()
+	{
+		for (std::unique_ptr<word[]>& page : pages) page.reset();
+		committed_pages = 0;
+
+		if (default_memory) WriteBlock(0, default_memory.get(), default_memory_words);
+	}
+}
\ No newline at end of file
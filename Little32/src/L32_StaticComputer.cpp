@@ -0,0 +1,57 @@
+#include "L32_StaticComputer.h"
+
+#include <cstdio>
+
+namespace Little32
+{
+	namespace
+	{
+		const char* DeviceTypeName(Device_ID id)
+		{
+			switch (id)
+			{
+				case NULL_DEVICE: return "NullDevice";
+				case COMPUTERINFO_DEVICE: return "ComputerInfo";
+				case ROM_DEVICE: return "ROM";
+				case RAM_DEVICE: return "RAM";
+				case CHARDISPLAY_DEVICE: return "CharDisplay";
+				case COLOURCHARDISPLAY_DEVICE: return "ColourCharDisplay";
+				case KEYBOARD_DEVICE: return "KeyboardDevice";
+				case SPARSE_RAM_DEVICE: return "SparseRAM";
+				case TIMER_DEVICE: return "TimerDevice";
+				case DMA_DEVICE: return "DMADevice";
+				default: return nullptr;
+			}
+		}
+
+		void WriteMapping(const IMemoryMapped& m, bool last, std::ostream& out)
+		{
+			const char* const type = DeviceTypeName(m.GetID());
+			if (type == nullptr) throw std::runtime_error("Device with ID " + std::to_string(m.GetID()) + " can't be part of a static computer");
+
+			char str[64];
+			snprintf(str, sizeof(str), "0x%08Xu, 0x%08Xu", m.GetAddress(), m.GetRange());
+
+			out << "\t\tStaticMapping<" << type << ", " << str << ">" << (last ? "" : ",") << "\n";
+		}
+	}
+
+	void WriteStaticComputer(const Computer& computer, const std::string& core_type, const std::string& type_name, std::ostream& out)
+	{
+		const size_t count = computer.mappings.size() + computer.mapped_devices.size();
+		size_t i = 0;
+
+		out << "// Generated from a Little32 config. Do not edit, regenerate it from the config instead\n\n";
+		out << "#pragma once\n\n";
+		out << "#include \"Little32.h\"\n\n";
+		out << "namespace Little32\n{\n";
+		out << "\tusing " << type_name << " = StaticComputer<" << core_type << (count == 0 ? ">;\n" : ",\n");
+
+		// In the same order Computer searches them
+		for (const IMemoryMapped* m : computer.mappings) WriteMapping(*m, ++i == count, out);
+		for (const IMappedDevice* m : computer.mapped_devices) WriteMapping(*m, ++i == count, out);
+
+		if (count != 0) out << "\t>;\n";
+		out << "}\n";
+	}
+}
\ No newline at end of file
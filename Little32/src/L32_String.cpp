@@ -3,16 +3,51 @@
 #include "L32_Computer.h"
 #include "L32_ICore.h"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 namespace Little32
 {
+	namespace
+	{
+		/// <summary> Reads memory a block at a time, for going through it a word at a time </summary>
+		class BlockReader
+		{
+			static constexpr word block_words = 256;
+
+			Computer& computer;
+			word end;
+			word offset;
+			word start = 0;
+			word count = 0;
+			word values[block_words] = {};
+
+		public:
+			BlockReader(Computer& computer, word end, word offset) : computer(computer), end(end), offset(offset) {}
+
+			/// <summary> Reads the word at addr + offset, where addr is before end </summary>
+			word Read(word addr)
+			{
+				if (addr - start >= count * sizeof(word))
+				{
+					start = addr;
+					count = std::min(block_words, (end - addr - 1) / (word)sizeof(word) + 1);
+					computer.ReadBlock(start + offset, values, count);
+				}
+
+				return values[(addr - start) / sizeof(word)];
+			}
+		};
+	}
+
 	void DisassembleMemory(Computer& computer, word start, word end, word offset, bool print_NOP)
 	{
+		BlockReader reader(computer, end, offset);
+
 		for (word laddr = start, addr = start; addr < end; addr += 4)
 		{
-			word v = computer.Read(addr + offset);
+			word v = reader.Read(addr);
 			std::string instruction = computer.core->Disassemble(v);
 			if (instruction == "NOP") continue;
 			if (addr - laddr > 12) printf("...\n");
@@ -36,11 +71,12 @@ namespace Little32
 	{
 		word laddr = start;
 		word end2 = ((end - start) & 0xFFFFFFFC) + start; // just in case
+		BlockReader reader(computer, end, offset);
 		if (!print_null)
 		{
 			for (; laddr != end2; laddr += 4)
 			{
-				if (computer.Read(laddr + offset) != 0) break;
+				if (reader.Read(laddr) != 0) break;
 			}
 			if (laddr == end2) return;
 		}
@@ -103,7 +139,7 @@ namespace Little32
 
 		for (word addr = laddr; addr < end; addr += 4)
 		{
-			const word v = computer.Read(addr + offset);
+			const word v = reader.Read(addr);
 			if (v == 0 && !print_null) continue;
 			std::string cp437 = "";
 			std::string ascii = "";
@@ -0,0 +1,272 @@
+#include "L32_TimerDevice.h"
+
+#include "L32_BigInt.h"
+#include "L32_Computer.h"
+#include "L32_IDeviceSettings.h"
+#include "L32_String.h"
+#include "L32_VarValue.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Little32
+{
+	TimerDevice::TimerDevice(Computer& computer, word address, word channel_count)
+		: address_start(address), channel_count(channel_count), computer(computer)
+	{
+		assert(channel_count >= 1 && channel_count <= max_channels);
+
+		interrupt_source = computer.interrupts.AddSource();
+		counter_start = computer.Now();
+	}
+
+	TimerDevice::~TimerDevice()
+	{
+		computer.interrupts.RemoveSource(interrupt_source);
+	}
+
+	void TimerDeviceFactory::CreateFromSettings(Computer& computer, word& start_address, const IDeviceSettings& settings, std::unordered_map<std::string, word>& labels, std::filesystem::path path) const
+	{
+		word channel_count = 4;
+
+		if (settings.Contains("channels"))
+		{
+			assert(settings["channels"].GetType() == INTEGER_VAR);
+			const BigInt& channels = settings["channels"].GetIntegerValue();
+			assert(!channels.negative && channels.bits.size() == 1);
+			channel_count = channels.bits[0];
+		}
+
+		TimerDevice* device = new TimerDevice(computer, start_address, channel_count);
+
+		computer.interrupts.SetPriority(device->interrupt_source, settings.GetInterruptPriority());
+
+		start_address += device->GetRange();
+		computer.AddMappedDevice(*device);
+	}
+
+	void TimerDeviceFactory::VerifySettings(const IDeviceSettings& settings, std::filesystem::path path) const
+	{
+		if (settings.Contains("channels")) MatchUIntRange<1, TimerDevice::max_channels>(settings["channels"], "channels");
+		settings.VerifyInterruptPriority();
+
+		if (!settings.named_labels.empty())
+		{
+			throw std::runtime_error("Unknown named label: '" + settings.named_labels.begin()->first + "'");
+		}
+	}
+
+	uint64_t TimerDevice::Counter() const
+	{
+		return computer.Now() - counter_start;
+	}
+
+	void TimerDevice::Arm(Channel& channel)
+	{
+		// The low word of the counter wraps round to the compare value, so it's never more than 2^32 cycles away
+		channel.due = computer.Now() + (word)(channel.compare - (word)Counter());
+	}
+
+	void TimerDevice::Clock()
+	{
+		const size_t now = computer.Now();
+
+		for (word i = 0; i < channel_count; i++)
+		{
+			Channel& channel = channels[i];
+
+			if ((channel.control & CONTROL_ENABLE) == 0 || channel.due > now) continue;
+
+			status |= 1 << i;
+
+			if (channel.interrupt != 0) computer.interrupts.Post(interrupt_source, channel.interrupt);
+
+			if ((channel.control & CONTROL_PERIODIC) != 0 && channel.period != 0)
+			{
+				// From when it was due rather than now, so the period doesn't drift when the timer is clocked late
+				channel.compare += channel.period;
+				channel.due += channel.period;
+			}
+			else
+			{
+				channel.control &= ~CONTROL_ENABLE;
+			}
+		}
+	}
+
+	size_t TimerDevice::CyclesUntilClock()
+	{
+		const size_t now = computer.Now();
+		size_t next = never;
+
+		for (word i = 0; i < channel_count; i++)
+		{
+			const Channel& channel = channels[i];
+
+			if ((channel.control & CONTROL_ENABLE) == 0) continue;
+
+			next = std::min(next, channel.due > now ? channel.due - now : 0);
+		}
+
+		return next;
+	}
+
+	void TimerDevice::Reset()
+	{
+		counter_start = computer.Now();
+		latched_high = 0;
+		status = 0;
+
+		channels.fill({});
+	}
+
+	word TimerDevice::Peek(word index) const
+	{
+		switch (index)
+		{
+		case COUNTER_LOW: return (word)Counter();
+		case COUNTER_HIGH: return latched_high;
+		case STATUS: return status;
+		case CHANNEL_COUNT: return channel_count;
+		}
+
+		index -= CHANNELS;
+
+		const word channel = index / channel_words;
+		if (channel >= channel_count) return 0;
+
+		switch (index % channel_words)
+		{
+		case CHANNEL_CONTROL: return channels[channel].control;
+		case CHANNEL_COMPARE: return channels[channel].compare;
+		case CHANNEL_PERIOD: return channels[channel].period;
+		default: return channels[channel].interrupt;
+		}
+	}
+
+	void TimerDevice::Write(word address, word value)
+	{
+		if (address % sizeof(word) != 0) return;
+
+		word index = address / sizeof(word);
+
+		switch (index)
+		{
+		case COUNTER_LOW:
+		case COUNTER_HIGH:
+		{
+			uint64_t counter = Counter();
+
+			if (index == COUNTER_LOW) counter = (counter & 0xFFFFFFFF00000000) | value;
+			else counter = (counter & 0x00000000FFFFFFFF) | ((uint64_t)value << 32);
+
+			counter_start = computer.Now() - counter;
+
+			// Compare values are against the counter, so every channel is reached at a different cycle now
+			for (word i = 0; i < channel_count; i++)
+			{
+				if ((channels[i].control & CONTROL_ENABLE) != 0) Arm(channels[i]);
+			}
+
+			computer.ScheduleClock(*this);
+			return;
+		}
+		case STATUS:
+			status &= ~value;
+			return;
+		case CHANNEL_COUNT:
+			return;
+		}
+
+		index -= CHANNELS;
+
+		const word c = index / channel_words;
+		if (c >= channel_count) return;
+
+		Channel& channel = channels[c];
+
+		switch (index % channel_words)
+		{
+		case CHANNEL_CONTROL:
+		{
+			const bool enabling = (channel.control & CONTROL_ENABLE) == 0 && (value & CONTROL_ENABLE) != 0;
+
+			channel.control = value & (CONTROL_ENABLE | CONTROL_PERIODIC);
+
+			// Rewriting the control of a channel that's already running leaves when it's due alone
+			if (!enabling) return;
+
+			Arm(channel);
+			computer.ScheduleClock(*this);
+			return;
+		}
+		case CHANNEL_COMPARE:
+			channel.compare = value;
+
+			if ((channel.control & CONTROL_ENABLE) == 0) return;
+
+			Arm(channel);
+			computer.ScheduleClock(*this);
+			return;
+		case CHANNEL_PERIOD:
+			channel.period = value;
+			return;
+		default:
+			channel.interrupt = value;
+			return;
+		}
+	}
+
+	void TimerDevice::WriteByte(word address, byte value)
+	{
+		if (address >= GetRange()) return;
+
+		const word aligned = address & ~3;
+		const word x = (address % sizeof(word)) * 8;
+
+		// Only the bits written are cleared, rather than every bit that's set in the rest of the word
+		if (aligned / sizeof(word) == STATUS)
+		{
+			Write(aligned, (word)value << x);
+			return;
+		}
+
+		// The high word of the counter as it is now, rather than as it was latched
+		const word current = aligned / sizeof(word) == COUNTER_HIGH ? (word)(Counter() >> 32) : Peek(aligned / sizeof(word));
+
+		Write(aligned, (current & ~((word)0xFF << x)) | ((word)value << x));
+	}
+
+	void TimerDevice::WriteForced(word address, word value)
+	{
+		Write(address, value);
+	}
+
+	void TimerDevice::WriteByteForced(word address, byte value)
+	{
+		WriteByte(address, value);
+	}
+
+	word TimerDevice::Read(word address)
+	{
+		if (address % sizeof(word) != 0) return 0;
+
+		const word index = address / sizeof(word);
+
+		if (index != COUNTER_LOW) return Peek(index);
+
+		// Read together, so the high word can't tick over between the two reads
+		const uint64_t counter = Counter();
+		latched_high = (word)(counter >> 32);
+		return (word)counter;
+	}
+
+	byte TimerDevice::ReadByte(word address)
+	{
+		if (address >= GetRange()) return 0;
+
+		const word x = (address % sizeof(word)) * 8;
+
+		return Read(address & ~3) >> x;
+	}
+}
\ No newline at end of file
@@ -40,6 +40,19 @@ namespace Little32
 
 			std::vector<std::array<Colour, 16>> palettes = {};
 
+			std::string core_type = "Little32";
+
+			// How many nested interrupts bank the core's registers instead of pushing to the stack, and which registers RFE restores from the bank
+			uint32_t register_banks = 0;
+			uint32_t banked_registers = 0b0101111111111111;
+
+			// The recompiled program run by the AOT core, and where to write the recompiled program after assembling
+			std::filesystem::path aot_module;
+			std::filesystem::path aot_output;
+
+			// Where to write a StaticComputer type with the same core and layout as the config
+			std::filesystem::path static_computer_output;
+
 			inline bool operator==(const Settings& other) const
 			{
 				if (!( start_address == other.start_address
@@ -57,7 +70,13 @@ namespace Little32
 					&& frame_delay == other.frame_delay
 					&& clocks_per_frame == other.clocks_per_frame
 					&& viewport_size == other.viewport_size
-					&& palettes.size() == other.palettes.size())) return false;
+					&& palettes.size() == other.palettes.size()
+					&& core_type == other.core_type
+					&& register_banks == other.register_banks
+					&& banked_registers == other.banked_registers
+					&& aot_module == other.aot_module
+					&& aot_output == other.aot_output
+					&& static_computer_output == other.static_computer_output)) return false;
 
 				for (size_t i = components.size(); i--;)
 				{
@@ -167,6 +186,24 @@ namespace Little32
 					{
 						{ "KEYBOARD", 0 }
 					}
+				},
+				{
+					4,
+					"Timer",
+					{},
+					{},
+					{
+						{ "TIMER", 0 }
+					}
+				},
+				{
+					5,
+					"DMA",
+					{},
+					{},
+					{
+						{ "DMA", 0 }
+					}
 				}
 			},
 
@@ -209,11 +246,106 @@ namespace Little32
 
 		Computer computer;
 		Little32Core core;
+		/// <summary> Only made while it's selected, as it maps memory for its code up front </summary>
+		std::unique_ptr<Little32JITCore> jit_core;
+		Little32AOTCore aot_core;
+		Little32Core* active_core;
 
-		Program() : assembler(), computer(), core(computer)
+		Program() : assembler(), computer(), core(computer), aot_core(computer), active_core(&core)
 		{
 			assembler.SetComputer(computer);
-			computer.core = &core;
+			computer.core = active_core;
+		}
+
+		void SelectCore()
+		{
+			if (settings.core_type == "Little32 JIT")
+			{
+				if (jit_core == nullptr)
+				{
+					jit_core = std::make_unique<Little32JITCore>(computer);
+					jit_core->register_banks = settings.register_banks;
+					jit_core->banked_registers = settings.banked_registers;
+				}
+
+				active_core = jit_core.get();
+			}
+			else if (settings.core_type == "Little32 AOT") active_core = &aot_core;
+			else active_core = &core;
+
+			computer.core = active_core;
+
+			if (active_core != jit_core.get()) jit_core.reset();
+
+			if (active_core != &aot_core) return;
+
+			// Without a module, the AOT core interprets everything
+			try
+			{
+				if (settings.aot_module.empty()) aot_core.Unload();
+				else aot_core.Load(settings.aot_module);
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << e.what() << std::endl;
+			}
+		}
+
+		// Writes the program in ROM out as C++ to be built into a module for the AOT core, if the settings ask for it
+		void RecompileProgram()
+		{
+			if (settings.aot_output.empty() || !settings.rom_set) return;
+
+			Little32Recompiler recompiler;
+			recompiler.SetROM(settings.rom_address, settings.rom_bytes);
+			recompiler.entry_points.push_back(computer.start_PC);
+
+			std::ofstream out(settings.aot_output);
+
+			if (!out.is_open())
+			{
+				std::cout << "Could not open recompiler output '" << settings.aot_output.string() << "'" << std::endl;
+				return;
+			}
+
+			try
+			{
+				recompiler.Recompile(computer, out);
+				std::cout << "Recompiled " << recompiler.blocks.size() << " blocks to '" << settings.aot_output.string() << "'" << std::endl;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << e.what() << std::endl;
+			}
+		}
+
+		// Writes out the layout of the computer as a StaticComputer, if the settings ask for it
+		void WriteStaticComputerType()
+		{
+			if (settings.static_computer_output.empty()) return;
+
+			const std::string core_type =
+				settings.core_type == "Little32 JIT" ? "Little32JITCore" :
+				settings.core_type == "Little32 AOT" ? "Little32AOTCore" :
+				"Little32Core";
+
+			std::ofstream out(settings.static_computer_output);
+
+			if (!out.is_open())
+			{
+				std::cout << "Could not open static computer output '" << settings.static_computer_output.string() << "'" << std::endl;
+				return;
+			}
+
+			try
+			{
+				WriteStaticComputer(computer, core_type, "StaticBoard", out);
+				std::cout << "Wrote static computer to '" << settings.static_computer_output.string() << "'" << std::endl;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << e.what() << std::endl;
+			}
 		}
 
 		const std::unordered_map<std::string, const IDeviceFactory* const> device_type_factories =
@@ -222,7 +354,9 @@ namespace Little32
 			{ "RAM", new RAMFactory() },
 			{ "ROM", new ROMFactory() },
 			{ "Colour Character Display", new ColourCharDisplayFactory() },
-			{ "Keyboard", new KeyboardDeviceFactory() }
+			{ "Keyboard", new KeyboardDeviceFactory() },
+			{ "Timer", new TimerDeviceFactory() },
+			{ "DMA", new DMADeviceFactory() }
 		};
 
 		// Assumes that incoming data is valid. Make sure it is.
@@ -233,6 +367,28 @@ namespace Little32
 			settings.frame_delay = new_settings.frame_delay;
 			settings.clocks_per_frame = new_settings.clocks_per_frame;
 
+			settings.aot_output = new_settings.aot_output;
+			settings.static_computer_output = new_settings.static_computer_output;
+
+			// Banks already in use are still returned from, so this can change while a handler runs
+			settings.register_banks = new_settings.register_banks;
+			settings.banked_registers = new_settings.banked_registers;
+			core.register_banks = aot_core.register_banks = settings.register_banks;
+			core.banked_registers = aot_core.banked_registers = settings.banked_registers;
+
+			if (jit_core != nullptr)
+			{
+				jit_core->register_banks = settings.register_banks;
+				jit_core->banked_registers = settings.banked_registers;
+			}
+
+			if (settings.core_type != new_settings.core_type || settings.aot_module != new_settings.aot_module)
+			{
+				settings.core_type = new_settings.core_type;
+				settings.aot_module = new_settings.aot_module;
+				SelectCore();
+			}
+
 			settings.ram_set = new_settings.ram_set;
 			settings.rom_set = new_settings.rom_set;
 
@@ -394,12 +550,15 @@ namespace Little32
 				components_unequal:
 				settings.components = new_settings.components;
 
+				// Unscheduled first, so the computer doesn't go on to clock devices that no longer exist
 				for (auto*& d : computer.devices)
 				{
+					computer.Unschedule(*d);
 					delete d;
 				}
 				for (auto*& md : computer.mapped_devices)
 				{
+					computer.Unschedule(*md);
 					delete md;
 				}
 				for (auto*& m : computer.mappings)
@@ -432,6 +591,8 @@ namespace Little32
 
 				assembler.AddLabels(labels);
 			}
+
+			WriteStaticComputerType();
 		}
 
 		// Assumes that incoming data is valid. Make sure it is.
@@ -439,6 +600,8 @@ namespace Little32
 		{
 			settings = new_settings;
 
+			SelectCore();
+
 			computer.start_PC = settings.start_address;
 			computer.start_SP = settings.start_SP;
 
@@ -523,12 +686,15 @@ namespace Little32
 				};
 			}
 
+			// Unscheduled first, so the computer doesn't go on to clock devices that no longer exist
 			for (auto*& d : computer.devices)
 			{
+				computer.Unschedule(*d);
 				delete d;
 			}
 			for (auto*& md : computer.mapped_devices)
 			{
+				computer.Unschedule(*md);
 				delete md;
 			}
 			for (auto*& m : computer.mappings)
@@ -560,6 +726,8 @@ namespace Little32
 			}
 
 			assembler.AddLabels(labels);
+
+			WriteStaticComputerType();
 		}
 
 		size_t LoadSettings(Settings& settings, const ConfigObject& new_settings, std::filesystem::path config_path, const bool throw_errors = true) const
@@ -623,6 +791,51 @@ namespace Little32
 				++exceptions;
 			}
 
+			if (new_settings.TryFindString("core", tmp_str))
+			{
+				if (tmp_str == "Little32" || tmp_str == "Little32 JIT" || tmp_str == "Little32 AOT")
+				{
+					settings.core_type = tmp_str;
+				}
+				else
+				{
+					if (throw_errors) throw std::runtime_error("Unknown core type ('" + tmp_str + "')");
+					std::cout << "Unknown core type ('" << tmp_str << "')" << std::endl;
+					++exceptions;
+				}
+			}
+
+			if (new_settings.TryFindInteger("register_banks", tmp_bint))
+			{
+				if (tmp_bint.negative || tmp_bint.NumBits() > 32 || (!tmp_bint.bits.empty() && tmp_bint.bits[0] > Little32Core::max_register_banks))
+				{
+					if (throw_errors) throw std::runtime_error("Register banks must be between 0 and " + std::to_string(Little32Core::max_register_banks) + " (" + tmp_bint.ToStringCheap() + ')');
+					std::cout << "Register banks must be between 0 and " << Little32Core::max_register_banks << " (" << tmp_bint.ToStringCheap() << ')' << std::endl;
+					++exceptions;
+				}
+				else
+				{
+					settings.register_banks = tmp_bint.bits.empty() ? 0 : static_cast<uint32_t>(tmp_bint.bits[0]);
+				}
+			}
+
+			new_settings.TryFindUInt32("banked_registers", settings.banked_registers);
+
+			if (new_settings.TryFindString("aot_module", tmp_str))
+			{
+				settings.aot_module = (config_path.parent_path() / tmp_str).lexically_normal();
+			}
+
+			if (new_settings.TryFindString("aot_output", tmp_str))
+			{
+				settings.aot_output = (config_path.parent_path() / tmp_str).lexically_normal();
+			}
+
+			if (new_settings.TryFindString("static_computer_output", tmp_str))
+			{
+				settings.static_computer_output = (config_path.parent_path() / tmp_str).lexically_normal();
+			}
+
 			new_settings.TryFindUInt32("start_address", settings.start_address);
 			new_settings.TryFindUInt32("stack_address", settings.start_SP);
 
@@ -1070,8 +1283,11 @@ namespace Little32
 						computer.start_PC = 0;
 					}
 
+					computer.ShareImages();
 					computer.SoftReset();
 
+					RecompileProgram();
+
 					printf("Program memory:\n");
 					DisassembleMemory(computer, assembler.program_start, assembler.program_end);
 					PrintMemory(computer, assembler.data_start, assembler.data_end, 0, true);
@@ -1096,11 +1312,26 @@ namespace Little32
 			(
 				[&](const Point, const Uint32)
 				{
+					const Little32Core& core = *active_core;
+
 					printf("PC: 0x%08X  SP: 0x%08X  LR: 0x%08X\n", core.PC, core.SP, core.LR);
 					printf(" R0: % 10i  R1: % 10i  R2: % 10i  R3: % 10i\n", core.R0, core.R1, core.R2, core.R3);
 					printf(" R4: % 10i  R5: % 10i  R6: % 10i  R7: % 10i\n", core.R4, core.R5, core.R6, core.R7);
 					printf(" R8: % 10i  R9: % 10i R10: % 10i R11: % 10i\n", core.R8, core.R9, core.R10, core.R11);
-					printf("R12: % 10i NZCV: %i%i%i%i \n", core.R12, core.N, core.Z, core.C, core.V);
+					const word flags = core.GetFlags();
+					printf("R12: % 10i NZCV: %i%i%i%i \n", core.R12, (flags >> 3) & 1, (flags >> 2) & 1, (flags >> 1) & 1, flags & 1);
+					printf("Fused: CMP+B: %zu  MOV+RRW: %zu  INC+CMP+B: %zu\n",
+						core.fusion_counts[(size_t)Little32Core::Fusion::COMPARE_BRANCH],
+						core.fusion_counts[(size_t)Little32Core::Fusion::LOAD],
+						core.fusion_counts[(size_t)Little32Core::Fusion::LOOP]);
+
+					for (IMappedDevice* m : computer.mapped_devices)
+					{
+						if (m->GetID() != SPARSE_RAM_DEVICE) continue;
+
+						const SparseRAM& ram = *static_cast<SparseRAM*>(m);
+						printf("Sparse RAM 0x%08X: %zu of %u bytes resident\n", ram.address_start, ram.GetResidentSize(), ram.address_size);
+					}
 
 					printf("0x%08X: %s\n\n", core.PC, core.Disassemble(computer.Read(core.PC)).c_str());
 
@@ -1185,8 +1416,11 @@ namespace Little32
 						computer.start_PC = 0;
 					}
 
+					computer.ShareImages();
 					computer.SoftReset();
 
+					RecompileProgram();
+
 					printf("Program memory:\n");
 					DisassembleMemory(computer, assembler.program_start, assembler.program_end);
 					PrintMemory(computer, assembler.data_start, assembler.data_end, 0, true);
@@ -1212,7 +1446,10 @@ namespace Little32
 
 					r.Present();
 
-					Delay(settings.frame_delay);
+					// A program waiting for an interrupt waits for input instead, as that's what interrupts it from this thread.
+					// The event is left queued for Input::Update, so the next frame delivers it as soon as it arrives
+					if (computer.core->IsHalted()) SDL_WaitEventTimeout(nullptr, (int)settings.frame_delay);
+					else Delay(settings.frame_delay);
 				}
 				else
 				{